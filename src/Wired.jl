@@ -14,11 +14,13 @@ module Wired
 
 const version = 1.0
 
-using LinearAlgebra: norm, dot, det
+using LinearAlgebra: norm, dot, det, cross, diag
 using DelimitedFiles
 using Logging 
 import Elliptic
 using StaticArrays
+using SHA: sha256
+import Mmap
 
 # Permeability of free space
 const mu0 = 4pi * (1e-7)
@@ -32,15 +34,49 @@ errmax = 1e-8
 kernel = "julia"        # other option is "c"
 
 # Define whether or not to "check inside" the radius of filaments 
-# and remove singularities
 check_inside = true
-remove_singularities = true
+
+# Define what node/source pairs at a singularity (a node on the axis of a wire 
+# or on the filament of a ring) add to the field: "zero" adds nothing for exact 
+# singularities, "limit" adds the limiting value for pairs that are singular to 
+# working precision, and "flag" does the same but returns NaN at their nodes
+singularity = "zero"
+
+# Deprecated, use `singularity`: when set, true stands for "zero" and false for 
+# "flag" (with a warning)
+remove_singularities = nothing
+
+# Define how the C kernel is threaded: "julia" splits the sources across Julia 
+# tasks, "native" splits the nodes across OpenMP threads inside the kernel
+threading = "julia"
+
+# Options for native threading on multi-socket (NUMA) machines
+numa_firsttouch = false     # place node/output partitions on the socket that uses them
+pin_threads = false         # pin kernel threads to cores
+socket_aware = false        # give each socket one contiguous block of nodes
+cpulist = Int[]             # cores to pin to (default: 0, 1, ..., Nt-1)
+
+# Define whether nodes and sources are sorted along a space-filling (Morton) curve 
+# before evaluation, so that neighbours in memory are neighbours in space; results 
+# are returned in the original order of the nodes
+reorder = false
+
+# Define whether results are reproducible: bit-identical for any number of threads. 
+# Julia-threaded sums over the sources use fixed blocks of `reproblock` sources, 
+# added in a fixed order; install the C kernel with installkernel(reproducible=true) 
+# for bit-identical results across machines as well. Small blocks keep every thread 
+# busy until the end; each block costs one extra Nx3 addition
+reproducible = false
+reproblock = 64
+
+# Directory of the on-disk cache used by bfield_cached (empty: no caching)
+cachedir = ""
 
 include("sources.jl")
-export Source, Wire, Ring, CircularRing, RectangularRing
+export Source, Wire, Ring, CircularRing, RectangularRing, OrientedRing, Tetrahedron
 
 include("fields.jl")
-export Line
+export Line, Grid, CartesianGrid, PlaneGrid, CylindricalGrid, fieldnodes
 
 include("mesh.jl")
 export Mesh
@@ -49,21 +85,50 @@ include("utils.jl")
 export ellipK, ellipE, ellipKE, crossrows!, normrows!, multrows!, dotrows!
 
 include("processing.jl")
-export makewires, makecircrings
+export makewires, makecircrings, maketets
 
 include("io.jl")
 export loadmesh, savemesh, loadrings, saverings, loadwires, savewires
 
 include("kernel.jl")
-export installkernel
+export installkernel, kernelstats, kernelreproducible
+
+include("ordering.jl")
+export mortonorder
 
 include("bs_ring.jl")
 include("bs_wire.jl")
-export bfield
+include("bs_tet.jl")
+include("bs_grid.jl")
+export bfield, bfield_batch, bfield_vjp, bfield_jacobian
+
+include("zonal.jl")
+export ZonalExpansion, bfield_zonal
+
+include("harmonic.jl")
+export bfield_multi
+
+include("reduce.jl")
+export FieldReduction, bfield_reduce, meanfield, energy, homogeneity
+
+include("adaptive.jl")
+export FieldTree, bfield_adaptive, interpolate
+
+include("cache.jl")
+export bfield_cached
+
+include("async.jl")
+export Job, submit, progress, status, partial, cancel!
+
+include("session.jl")
+export Session, update!, rescale!, refresh!
+
+include("mpi.jl")
+export bfield_mpi, installmpi
 
 include("solve.jl")
 
 include("lorentz.jl")
-export lorentz, netload
+export lorentz, netload, CoilForces, coilforces
 
 end # module
@@ -0,0 +1,194 @@
+""" Wired.jl
+    Adaptive field maps on octrees
+"""
+
+
+"""
+    struct FieldTree
+
+B-field sampled on an octree of axis-aligned cells (a quadtree for a planar box),
+refined only where the field is not well represented by trilinear interpolation
+between the corners of a cell. Use `interpolate` to evaluate it.
+
+Cells that are not refined are leaves; neighbouring leaves may be at different
+levels, so the interpolated field is continuous within a leaf but not always
+across the faces between leaves of different size.
+
+# Fields
+- `lo::SVector{3}`: lower corner of the box
+- `h::SVector{3}`: size of the root cells (zero along flat axes)
+- `dims::NTuple{3,Int}`: number of root cells along each axis
+- `maxdepth::Int`: maximum number of refinements of a root cell
+- `nodes::Matrix`: Nx3 points at which the field was evaluated
+- `B::Matrix`: Nx3 field at each of the `nodes`
+- `cellkey::Vector{NTuple{3,Int}}`: lower corner of each cell, in units of
+    `h / 2^maxdepth`
+- `level::Vector{Int}`: number of refinements from the root to each cell
+- `corners::Vector{NTuple{8,Int}}`: rows of `nodes` at the corners of each cell
+    (x varies fastest, then y, then z)
+- `children::Vector{Int}`: first child of each cell (its children are stored
+    together), or 0 for a leaf
+"""
+struct FieldTree{T<:Real}
+    lo::SVector{3, T}
+    h::SVector{3, T}
+    dims::NTuple{3, Int}
+    maxdepth::Int
+    nodes::Matrix{T}
+    B::Matrix{T}
+    cellkey::Vector{NTuple{3, Int}}
+    level::Vector{Int}
+    corners::Vector{NTuple{8, Int}}
+    children::Vector{Int}
+end
+
+
+"""
+    bfield_adaptive(lo, hi, sources; rtol=1e-3, atol=0.0, N0=4, mindepth=0, maxdepth=6, kwargs...)
+
+Sample the B-field generated by `sources` in the box with corners `lo` and `hi`,
+refining only where it is needed. A box with zero extent along an axis gives a
+planar (quadtree) map.
+
+The box starts as `N0` root cells along each axis. Each cell is checked by
+evaluating the field at its centre and comparing it with the trilinear
+interpolation from its corners; it is split into 8 (or 4) children when the
+difference exceeds `atol + rtol * max|B|`, down to `maxdepth` levels. The centre
+of a split cell is a corner of its children, so no evaluation is wasted.
+
+All the new points of one refinement level are evaluated in a single `bfield`
+call (with `kwargs`, e.g. `mu_r`, `Nt`, `Nmin`), so each level runs at the speed
+of a batched kernel call.
+
+# Returns
+`FieldTree`; the number of field evaluations is `size(tree.nodes, 1)`
+"""
+function bfield_adaptive(lo::AbstractVector{<:Real}, hi::AbstractVector{<:Real}, sources::Vector{<:Source};
+                            rtol=1e-3, atol=0.0, N0::Integer=4, mindepth::Integer=0,
+                            maxdepth::Integer=6, kwargs...)
+
+    T = precision
+    lo = SVector{3, T}(lo)
+    active = ntuple(d -> (hi[d] - lo[d]) > 0, 3)
+    dims = ntuple(d -> active[d] ? Int(N0) : 1, 3)
+    h = SVector{3, T}(ntuple(d -> active[d] ? (hi[d] - lo[d])/N0 : 0, 3))
+    dirs = [d for d in 1:3 if active[d]]
+    scale = 2^maxdepth
+
+    pointid = Dict{NTuple{3, Int}, Int}()
+    nodes = zeros(T, 0, 3)
+    B = zeros(T, 0, 3)
+    cellkey = NTuple{3, Int}[]
+    level = Int[]
+    corners = NTuple{8, Int}[]
+    children = Int[]
+
+    # Lattice coordinates of the corners (and centre) of a cell
+    cellsize(c) = ntuple(d -> active[d] ? scale >> level[c] : 0, 3)
+    cornerkey(c, b) = cellkey[c] .+ ntuple(d -> ((b >> (d-1)) & 1) * cellsize(c)[d], 3)
+    centrekey(c) = cellkey[c] .+ cellsize(c) .÷ 2
+
+    function newcell!(key, l)
+        push!(cellkey, key)
+        push!(level, l)
+        push!(corners, ntuple(b -> 0, 8))
+        push!(children, 0)
+        return length(cellkey)
+    end
+
+    candidates = [newcell!((Tuple(I) .- 1) .* scale, 0) for I in CartesianIndices(dims)]
+    while !isempty(candidates)
+
+        # Evaluate every new corner and centre of this level in one call
+        newkeys = NTuple{3, Int}[]
+        for c in candidates
+            pts = [cornerkey(c, b) for b in 0:7]
+            level[c] < maxdepth && push!(pts, centrekey(c))
+            for k in pts
+                if !haskey(pointid, k)
+                    pointid[k] = size(nodes, 1) + length(newkeys) + 1
+                    push!(newkeys, k)
+                end
+            end
+        end
+        if !isempty(newkeys)
+            newnodes = [lo[d] + k[d]*h[d]/scale for k in newkeys, d in 1:3]
+            nodes = vcat(nodes, newnodes)
+            B = vcat(B, convert.(T, bfield(newnodes, sources; kwargs...)))
+        end
+        tol = atol + rtol*maximum(norm, eachrow(B))
+
+        # Split the cells whose centre is not predicted by their corners
+        next = Int[]
+        for c in candidates
+            corners[c] = ntuple(b -> pointid[cornerkey(c, b-1)], 8)
+            level[c] < maxdepth || continue
+
+            Bmean = sum(B[i,:] for i in corners[c]) ./ 8
+            if level[c] < mindepth || norm(B[pointid[centrekey(c)],:] .- Bmean) > tol
+                children[c] = length(cellkey) + 1
+                half = scale >> (level[c] + 1)
+                for b in 0:(2^length(dirs) - 1)
+                    offset = ntuple(d -> 0, 3)
+                    for (n, d) in enumerate(dirs)
+                        offset = Base.setindex(offset, ((b >> (n-1)) & 1) * half, d)
+                    end
+                    push!(next, newcell!(cellkey[c] .+ offset, level[c] + 1))
+                end
+            end
+        end
+        candidates = next
+    end
+
+    return FieldTree{T}(lo, h, dims, maxdepth, nodes, B, cellkey, level, corners, children)
+end
+
+
+"""
+    interpolate(tree::FieldTree, nodes::AbstractArray)
+
+Interpolate the field stored in a `FieldTree` at a collection of points (Nx3
+`Matrix`, or a single 3-length point), trilinearly within the leaf cell containing
+each point. Points outside the box take the value at the nearest point of the box.
+"""
+function interpolate(tree::FieldTree{T}, nodes::AbstractMatrix{<:Real}) where T<:Real
+    B = zeros(T, size(nodes, 1), 3)
+    for i in axes(nodes, 1)
+        B[i,:] = interpolate(tree, nodes[i,:])
+    end
+    return B
+end
+
+function interpolate(tree::FieldTree{T}, x::AbstractVector{<:Real}) where T<:Real
+
+    scale = 2^tree.maxdepth
+    active = ntuple(d -> tree.h[d] > 0, 3)
+    dirs = [d for d in 1:3 if active[d]]
+
+    # Root cell, then down to the leaf containing the point
+    root = ntuple(d -> active[d] ? clamp(floor(Int, (x[d] - tree.lo[d])/tree.h[d]), 0, tree.dims[d]-1) : 0, 3)
+    c = LinearIndices(tree.dims)[(root .+ 1)...]
+    u = zeros(T, 3)
+    while true
+        sz = scale >> tree.level[c]
+        for d in dirs
+            origin = tree.lo[d] + tree.cellkey[c][d]*tree.h[d]/scale
+            u[d] = clamp((x[d] - origin) / (sz*tree.h[d]/scale), 0, 1)
+        end
+        tree.children[c] == 0 && break
+
+        child = 0
+        for (n, d) in enumerate(dirs)
+            child += (u[d] >= 0.5) << (n-1)
+        end
+        c = tree.children[c] + child
+    end
+
+    # Trilinear interpolation between the corners
+    B = zeros(T, 3)
+    for b in 0:7
+        w = prod(((b >> (d-1)) & 1) == 1 ? u[d] : 1 - u[d] for d in 1:3)
+        B .+= w .* tree.B[tree.corners[c][b+1],:]
+    end
+    return B
+end
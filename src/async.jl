@@ -0,0 +1,155 @@
+""" Wired.jl
+    Asynchronous (non-blocking) B-field evaluation
+"""
+
+
+"""
+    mutable struct Job
+
+Handle to a B-field calculation running in the background, returned by `submit`.
+
+The nodes are calculated in chunks, one chunk after another, each with a regular 
+`bfield` call (so each chunk uses every thread of the chosen kernel). Between chunks 
+the job updates its progress and checks whether it has been cancelled. Chunks finish 
+in order, so the first `completed[]` chunks are the finished ones.
+
+# Fields 
+- `B::Matrix`: Nx3 output; rows of chunks that have not finished are zero
+- `chunks::Vector{UnitRange{Int}}`: node rows of each chunk
+- `completed::Threads.Atomic{Int}`: number of finished chunks
+- `cancelled::Threads.Atomic{Bool}`: set by `cancel!`
+- `task::Task`: background task running the chunks
+"""
+mutable struct Job{T<:Real}
+    B::Matrix{T}
+    chunks::Vector{UnitRange{Int}}
+    completed::Threads.Atomic{Int}
+    cancelled::Threads.Atomic{Bool}
+    task::Task
+
+    function Job{T}(Nn::Integer, chunksize::Integer) where T<:Real
+        chunks = [i:min(i + chunksize - 1, Nn) for i in 1:chunksize:Nn]
+        job = new(zeros(T, Nn, 3), chunks, Threads.Atomic{Int}(0), Threads.Atomic{Bool}(false))
+        return job
+    end
+end
+
+
+"""
+    submit(nodes, sources; chunksize=4096, kwargs...)
+
+Start calculating `bfield(nodes, sources; kwargs...)` in the background and return a 
+`Job` at once. 
+
+Smaller chunks make `progress`, `partial` and `cancel!` more responsive; larger ones 
+amortize the fixed cost of each kernel call. A call into the C kernel cannot be 
+interrupted, so cancellation takes effect at the end of the current chunk.
+"""
+function submit(nodes::AbstractMatrix{<:Real}, sources::Vector{<:Source}; 
+                chunksize::Integer=4096, kwargs...)
+
+    job = Job{findparam(sources)}(size(nodes, 1), chunksize)
+    job.task = Threads.@spawn begin
+        for rows in job.chunks
+            job.cancelled[] && break
+            job.B[rows,:] = bfield(nodes[rows,:], sources; kwargs...)
+            Threads.atomic_add!(job.completed, 1)
+        end
+        job
+    end
+
+    return job
+end
+
+
+# Node rows of the chunks finished so far. The atomic counter is read once, and is 
+# only incremented after a chunk's rows of B have been written
+function finishedrows(job::Job)
+    n = job.completed[]
+    return (n == 0) ? (1:0) : (1:last(job.chunks[n]))
+end
+
+
+"""
+    progress(job::Job)
+
+Fraction of the nodes of a `Job` that have been calculated.
+"""
+function progress(job::Job)
+    Nn = size(job.B, 1)
+    return (Nn == 0) ? 1.0 : length(finishedrows(job)) / Nn
+end
+
+
+"""
+    status(job::Job)
+
+`:running`, `:done`, `:cancelled` (stopped early by `cancel!`) or `:failed`.
+"""
+function status(job::Job)
+    if !istaskdone(job.task)
+        return :running
+    elseif istaskfailed(job.task)
+        return :failed
+    elseif job.completed[] < length(job.chunks)
+        return :cancelled
+    end
+    return :done
+end
+
+
+"""
+    partial(job::Job)
+
+Results available so far: the node rows that have been calculated, and their B-field 
+(an Mx3 `Matrix`). Safe to call while the job is running.
+"""
+function partial(job::Job)
+    rows = collect(finishedrows(job))
+    return rows, job.B[rows,:]
+end
+
+
+"""
+    cancel!(job::Job)
+
+Ask a `Job` to stop after the chunk it is working on. Results of finished chunks stay 
+available through `partial`.
+"""
+function cancel!(job::Job)
+    job.cancelled[] = true
+    return job
+end
+
+
+"""
+    isready(job::Job)
+
+Poll a `Job`: true once it has finished, been cancelled or failed.
+"""
+Base.isready(job::Job) = istaskdone(job.task)
+
+
+"""
+    wait(job::Job)
+
+Block until a `Job` has finished or stopped; rethrows any error from the calculation.
+"""
+function Base.wait(job::Job)
+    wait(job.task)
+    return job
+end
+
+
+"""
+    fetch(job::Job)
+
+Wait for a `Job` and return its Nx3 B-field. Errors if the job was cancelled.
+"""
+function Base.fetch(job::Job)
+    wait(job)
+    if status(job) == :cancelled
+        error("Job was cancelled; use partial() for the finished chunks.")
+    end
+    return job.B
+end
@@ -0,0 +1,77 @@
+""" Wired.jl
+    Biot-Savart solvers for structured-grid fields
+"""
+
+
+"""
+    bfield(grid::Grid, wires::Vector{Wire}; mu_r=1.0, Nt=0, counts=nothing)
+
+Calculate the B-field at every point of a `Grid`, generated by a series of `Wire` 
+objects.
+
+With the C kernel, the grid points are generated inside the kernel and never stored, 
+and the rows of the grid are split across `Nt` native threads (for any 
+`Wired.threading`). With the Julia kernel, the points are formed with `fieldnodes`. 
+Nodes on the axis of a wire are treated according to `Wired.singularity`, and the 
+number of node/wire pairs at a singularity is added to `counts` (a `Vector{Int32}` 
+with one entry per grid point), as for `bfield(nodes, wires)`.
+
+# Returns
+Nx3 `Matrix` of magnetic flux density vectors, with the first grid index varying 
+fastest (`reshape(B, size(grid)..., 3)`)
+"""
+function bfield(grid::Grid{T}, wires::Vector{Wire{S}}; 
+                Nt::Integer=0, mu_r=1.0, counts=nothing) where {T<:Real, S<:AbstractFloat}
+
+    if kernel == "c"
+        return bs_cwires_grid(Grid{S}(grid), wires; mu_r=mu_r, 
+                              Nt=(Nt == 0 ? Threads.nthreads() : Nt), counts=counts)
+    end
+
+    return bfield(fieldnodes(Grid{S}(grid)), wires; Nt=Nt, mu_r=mu_r, counts=counts)
+end
+
+
+"""
+    bfield(grid::CylindricalGrid, rings::Vector{Ring}; mu_r=1.0, Nmin=2, errmax=1e-8, Nt=0, counts=nothing)
+
+Calculate the B-field at every point of a `CylindricalGrid`, generated by a series of 
+`CircularRing` or `RectangularRing` objects.
+
+With the C kernel, the rings (which are coaxial with the grid) are evaluated once per 
+(r, z) pair and rotated to every azimuth, without forming the grid points; 
+`RectangularRing`'s are filamentized with `makecircrings` first. The Julia kernel uses 
+`fieldnodes`, as does the C kernel when `counts` are wanted or unless 
+`Wired.singularity = "zero"` (the rotated evaluation only removes nodes exactly on a 
+filament, without counting them). The number of node/filament pairs at a singularity 
+is added to `counts` as for `bfield(nodes, rings)`.
+
+# Returns
+Nx3 `Matrix` of magnetic flux density vectors, with the first grid index varying 
+fastest (`reshape(B, size(grid)..., 3)`)
+"""
+function bfield(grid::CylindricalGrid{T}, rings::Union{Vector{<:CircularRing}, Vector{<:RectangularRing}}; 
+                mu_r=1.0, Nmin=2, errmax=1e-8, Nt=0, counts=nothing) where T<:Real
+
+    if kernel == "c" && singularpolicy() == 0 && isnothing(counts)
+        P = findparam(rings)
+        if !isa(rings, Vector{CircularRing{P}})
+            rings = makecircrings(rings, Nmin)
+        end
+        return bs_crings_cylgrid(CylindricalGrid{P}(grid), rings; mu_r=mu_r, 
+                                 Nt=(Nt == 0 ? Threads.nthreads() : Nt))
+    end
+
+    return bfield(fieldnodes(grid), rings; mu_r=mu_r, Nmin=Nmin, errmax=errmax, Nt=Nt, counts=counts)
+end
+
+
+"""
+    bfield(field::Field, sources::Vector{<:Source}; kwargs...)
+
+Calculate the B-field at the points of any `Field`, by forming its points with 
+`fieldnodes`.
+"""
+function bfield(field::Field, sources::Vector{<:Source}; kwargs...)
+    return bfield(fieldnodes(field), sources; kwargs...)
+end
@@ -4,14 +4,15 @@
 
 """
     biotsavart!(B::AbstractArray, nodes::AbstractArray, rings::CircularRings; 
-                errmax=1e-16)
+                errmax=1e-16, counts=nothing)
 
 Calculate the magnetic flux density at nodes in 3D space generated by a series of 
 circular current-carrying rings.
 
 Modifies an existing array containing the magnetic flux density components in-place. 
 Performs a current density correction for points within the specified minor radius 
-of the loop. Zeroes out singularity points. 
+of the loop. Nodes on a ring filament are treated according to `Wired.singularity`, 
+and the number of singular pairs of each node is added to `counts` if given.
 
 Reference:
 "Simple Analytic Expressions for the Magnetic Field of a Circular Current Loop"
@@ -19,7 +20,7 @@ Simpson, Lane, Immer, Youngquist (2001)
 https://ntrs.nasa.gov/api/citations/20010038494/downloads/20010038494.pdf 
 """
 @views function biotsavart!(B::AbstractArray{T}, nodes::AbstractArray{T}, rings::AbstractArray{CircularRing{T}}; 
-                            errmax=1e-8, mu_r=1.0) where T<:Real
+                            errmax=1e-8, mu_r=1.0, counts=nothing) where T<:Real
 
     T_ = T
     if !(T<:AbstractFloat)
@@ -36,9 +37,16 @@ https://ntrs.nasa.gov/api/citations/20010038494/downloads/20010038494.pdf
     E = zeros(T_, Nnodes)
     K = zeros(T_, Nnodes)
     Jdensity_correction = zeros(T_, Nnodes)
-
-    # In-plane radius for each node 
+    g = zeros(T_, Nnodes)
+    s = falses(Nnodes)
+    sing = zeros(Int32, Nnodes)
+    policy = singularpolicy()
+    tol2 = singulartol2(T_, policy)
+
+    # In-plane radius for each node, and 1/rho^2 (zero on the axis, where Bx and 
+    # By vanish)
     rho = sqrt.(nodes[:,1].^2 .+ nodes[:,2].^2)
+    irho2 = ifelse.(rho .> 0, 1 ./ rho.^2, zero(T_))
  
     for ring in rings
 
@@ -46,34 +54,41 @@ https://ntrs.nasa.gov/api/citations/20010038494/downloads/20010038494.pdf
         C = mu0 * ring.I / pi
 
         # Calculate intermediate variables 
+        # a2 is the squared distance to the ring filament
         r .= sqrt.(nodes[:,1].^2 .+ nodes[:,2].^2 .+ (nodes[:,3] .- ring.H).^2)
-        a2 .= a.^2 .+ r.^2 .- 2 .* a .* rho 
-        alpha .= sqrt.(abs.(a2))
+        a2 .= (rho .- a).^2 .+ (nodes[:,3] .- ring.H).^2
+        alpha .= sqrt.(a2)
         beta .= sqrt.(a^2 .+ r.^2 .+ 2 .* a .*rho)
-        k2 .= 1 .- a2./(beta.^2)
+
+        # Nodes on the filament are singular, and add nothing
+        s .= .!(a2 .> tol2 .* beta.^2)
+        sing .+= s
+        k2 .= ifelse.(s, zero(T_), 1 .- a2./(beta.^2))
 
         # Solve elliptic integrals
         K .= ellipK.(k2; errmax=errmax)
         E .= ellipE.(k2; errmax=errmax)
 
         # Calculate magnetic flux density 
-        B_[:,1] .= mu_r .* (C .* nodes[:,1] .* nodes[:,3] ./ (2 .* a2 .* beta .* rho.^2)) .* ((a^2 .+ r.^2) .* E .- a2.*K)  
-        B_[:,2] .= mu_r .* B_[:,1] .* nodes[:,2] ./ nodes[:,1]       # Note singularity
-        B_[:,3] .= mu_r .* (C ./ (2 .* a2 .* beta)) .* ((a.^2 .- r.^2) .* E .+ a2 .* K)
+        g .= ifelse.(s, zero(T_), mu_r .* C ./ (2 .* a2 .* beta))
+        B_[:,1] .= (g .* nodes[:,1] .* (nodes[:,3] .- ring.H) .* irho2) .* ((a^2 .+ r.^2) .* E .- a2.*K)  
+        B_[:,2] .= (g .* nodes[:,2] .* (nodes[:,3] .- ring.H) .* irho2) .* ((a^2 .+ r.^2) .* E .- a2.*K)
+        B_[:,3] .= g .* ((a.^2 .- r.^2) .* E .+ a2 .* K)
 
-        # Zero out singularity points and correct when inside the minor radius
+        # Correct when inside the minor radius
         # https://discourse.julialang.org/t/avoiding-allocations-in-a-map-over-a-tuple/105734/2
-        map!(x -> isnan(x) ? 0.0 : x, B_, B_)
         map!(x -> x < ring.r ? (x^2)/ring.r^2 : 1.0, Jdensity_correction, alpha)
         B .+= B_ .*= Jdensity_correction
 
     end
+
+    return singularfinish!(B, sing, counts, policy)
 end
 
 
 """
     biotsavart(nodes::AbstractArray, rings::AbstractArray{CircularRing}; 
-                    mu_r=1.0, errmax=1e-16)
+                    mu_r=1.0, errmax=1e-16, counts=nothing)
 
 Calculate the magnetic flux density at nodes in 3D space caused by a series of 
 circular current-carrying rings.
@@ -81,13 +96,13 @@ circular current-carrying rings.
 Allocates a new array for the magnetic flux density solution.
 """
 function biotsavart(nodes::AbstractArray{T}, rings::AbstractArray{CircularRing{T}}; 
-                    mu_r=1.0, errmax=1e-16) where T<:Real
+                    mu_r=1.0, errmax=1e-16, counts=nothing) where T<:Real
 
     if Wired.kernel == "julia"
         B = zeros(T, size(nodes))
-        biotsavart!(B, nodes, rings; mu_r=mu_r, errmax=errmax)
+        biotsavart!(B, nodes, rings; mu_r=mu_r, errmax=errmax, counts=counts)
     else
-        B = bs_crings(nodes, rings; mu_r=mu_r)      # Need to pass errmax
+        B = bs_crings(nodes, rings; mu_r=mu_r, counts=counts)      # Need to pass errmax
     end
 
     return B
@@ -103,16 +118,21 @@ Calculate the magnetic flux density for a series of circular loops with rectangu
 Allocates a new array for the B-field components.
 """
 function biotsavart(nodes::AbstractArray{T}, rect::AbstractArray{RectangularRing{T}}; 
-                        mu_r=1.0, Nmin=2, errmax=1e-8) where T<:Real
+                        mu_r=1.0, Nmin=2, errmax=1e-8, counts=nothing) where T<:Real
+
+    # The C kernel integrates over the cross-section directly
+    if Wired.kernel == "c"
+        return bs_crectrings(nodes, rect; mu_r=mu_r, errmax=errmax)
+    end
 
     # Convert to circular rings first 
     circ = makecircrings(rect, Nmin) 
-    return biotsavart(nodes, circ; mu_r=mu_r, errmax=errmax)
+    return biotsavart(nodes, circ; mu_r=mu_r, errmax=errmax, counts=counts)
 end
 
 
 """
-    bfield(nodes::AbstractArray, rings::Vector{Ring}; Nmin=2, errmax=1e-8, Nt=0)
+    bfield(nodes::AbstractArray, rings::Vector{Ring}; Nmin=2, errmax=1e-8, Nt=0, counts=nothing, reorder=Wired.reorder)
 
 Calculate the B-field at a collection of points in 3D space, generated by a series of
 `Ring` objects.
@@ -120,16 +140,24 @@ Calculate the B-field at a collection of points in 3D space, generated by a seri
 # Arguments
 - `nodes::AbstractArray`: Nx3 `Matrix` containing (x,y,z) coordinates of points in 3D space
 - `wires::Vector{<:Ring}`: `Ring` objects contributing to the magnetic field (circular or rectangular cross-section)
-- `Nmin::Integer`: minimum number of `CircularRing` objects to use to represent the shortest edge of a rectangular cross-section
-- `errmax::Float64`: maximum error tolerance for elliptic integral calculations
+- `Nmin::Integer`: minimum number of `CircularRing` objects to use to represent the shortest edge of a rectangular cross-section (Julia kernel)
+- `errmax::Float64`: maximum error tolerance for elliptic integral calculations, and for the cross-section quadrature of the C kernel
 - `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+- `counts`: `Vector{Int32}` with one entry per node, to which the number of node/filament pairs at a singularity is added (see `Wired.singularity`; not with the C kernel for rectangular cross-sections, which integrates over them)
+- `reorder::Bool`: sort the nodes and sources along a Morton curve for locality before evaluation (default: `Wired.reorder`); the result is in the original order of the nodes
 
 # Returns
 Nx3 `Matrix` containing magnetic flux density vectors at each of the points in 3D space represented by `nodes`
 
 """
 function bfield(nodes::AbstractArray{T}, rings::Vector{<:Ring}; 
-                mu_r=1.0, Nmin=2, errmax=1e-8, Nt=0) where T<:Real
+                mu_r=1.0, Nmin=2, errmax=1e-8, Nt=0, counts=nothing, reorder::Bool=Wired.reorder) where T<:Real
+
+    if reorder
+        return inorder(nodes, rings; Nt=Nt, counts=counts) do n, r, c
+            bfield(n, r; mu_r=mu_r, Nmin=Nmin, errmax=errmax, Nt=Nt, counts=c, reorder=false)
+        end
+    end
 
     P = findparam(rings)
     if P != T 
@@ -144,21 +172,156 @@ function bfield(nodes::AbstractArray{T}, rings::Vector{<:Ring};
         println("Error. Number of threads specified is greater than available threads.")
     end
 
-    # Spawn a new task for each thread by splitting up the source array
-    tasks = Vector{Task}(undef, Nt)
-    for it = 1:Nt 
+    # Native threading splits the nodes inside the C kernel instead
+    if kernel == "c" && threading == "native"
+        if isa(rings, Vector{RectangularRing{P}})
+            return bs_crectrings_native(nodes, rings; mu_r=mu_r, errmax=errmax, Nt=Nt)
+        elseif !isa(rings, Vector{CircularRing{P}})
+            rings = makecircrings(rings, Nmin)
+        end
+        return bs_crings_native(nodes, rings; mu_r=mu_r, Nt=Nt, counts=counts)
+    end
+
+    # Split up the source array across tasks (see sumsources); each task counts the 
+    # singular pairs of its sources separately
+    return sumsources(zeros(P, size(nodes)), Nt, Ns, counts) do idx, c
         if isa(rings, Vector{CircularRing{P}})
-            @views tasks[it] = Threads.@spawn biotsavart(nodes, rings[threadindices(it, Nt, Ns)]; mu_r=mu_r, errmax=errmax)
+            @views biotsavart(nodes, rings[idx]; mu_r=mu_r, errmax=errmax, counts=c)
         else 
-            @views tasks[it] = Threads.@spawn biotsavart(nodes, rings[threadindices(it, Nt, Ns)]; mu_r=mu_r, errmax=errmax, Nmin=Nmin)
+            @views biotsavart(nodes, rings[idx]; mu_r=mu_r, errmax=errmax, Nmin=Nmin, counts=c)
         end
     end
-    
-    # Get the result from each calculation and add it to the output array 
-    B = zeros(P, size(nodes))
-    for it = 1:Nt 
-        B .+= fetch(tasks[it]) 
-    end 
+end
 
-    return B
-end
\ No newline at end of file
+"""
+    biotsavart!(B::AbstractArray, nodes::AbstractArray, rings::AbstractArray{OrientedRing}; 
+                errmax=1e-8, mu_r=1.0, counts=nothing)
+
+Calculate the magnetic flux density at nodes in 3D space generated by a series of 
+circular current-carrying rings with arbitrary centroid and axis.
+
+Each node is described in the frame of the ring by its height `zl` along the axis and 
+its offset `u` from the axis, so that B = (Brho/rho) u + Bz n. Otherwise identical 
+to the `CircularRing` method.
+"""
+@views function biotsavart!(B::AbstractArray{T}, nodes::AbstractArray{T}, rings::AbstractArray{OrientedRing{T}}; 
+                            errmax=1e-8, mu_r=1.0, counts=nothing) where T<:Real
+
+    Nnodes = size(nodes)[1]
+    B_ = zeros(T, Nnodes, 3)
+    u = zeros(T, Nnodes, 3)
+    zl = zeros(T, Nnodes)
+    rho = zeros(T, Nnodes)
+    r2 = zeros(T, Nnodes)
+    a2 = zeros(T, Nnodes)
+    beta = zeros(T, Nnodes)
+    k2 = zeros(T, Nnodes)
+    E = zeros(T, Nnodes)
+    K = zeros(T, Nnodes)
+    f = zeros(T, Nnodes)
+    g = zeros(T, Nnodes)
+    Jdensity_correction = zeros(T, Nnodes)
+    s = falses(Nnodes)
+    sing = zeros(Int32, Nnodes)
+    policy = singularpolicy()
+    tol2 = singulartol2(T, policy)
+
+    for ring in rings
+
+        a = ring.R
+        n = ring.normal
+        C = mu0 * ring.I / pi
+
+        # Transform to the frame of the ring
+        u .= nodes .- ring.center'
+        zl .= u[:,1] .* n[1] .+ u[:,2] .* n[2] .+ u[:,3] .* n[3]
+        u .-= zl .* n'
+        rho .= sqrt.(u[:,1].^2 .+ u[:,2].^2 .+ u[:,3].^2)
+
+        # Calculate intermediate variables 
+        r2 .= rho.^2 .+ zl.^2
+        a2 .= (rho .- a).^2 .+ zl.^2
+        beta .= sqrt.((rho .+ a).^2 .+ zl.^2)
+
+        # Nodes on the filament are singular, and add nothing
+        s .= .!(a2 .> tol2 .* beta.^2)
+        sing .+= s
+        k2 .= ifelse.(s, zero(T), 1 .- a2./(beta.^2))
+
+        # Solve elliptic integrals
+        K .= ellipK.(k2; errmax=errmax)
+        E .= ellipE.(k2; errmax=errmax)
+
+        # Radial component divided by rho (zero on the axis), and axial component
+        g .= ifelse.(s, zero(T), mu_r .* C ./ (2 .* a2 .* beta))
+        f .= (g .* zl .* ifelse.(rho .> 0, 1 ./ rho.^2, zero(T))) .* ((a^2 .+ r2) .* E .- a2.*K)
+        B_[:,3] .= g .* ((a^2 .- r2) .* E .+ a2 .* K)
+
+        # Rotate back to the global frame
+        B_[:,1] .= f .* u[:,1] .+ B_[:,3] .* n[1]
+        B_[:,2] .= f .* u[:,2] .+ B_[:,3] .* n[2]
+        B_[:,3] .= f .* u[:,3] .+ B_[:,3] .* n[3]
+
+        # Correct when inside the minor radius
+        map!(x -> x < ring.r^2 ? x/ring.r^2 : 1.0, Jdensity_correction, a2)
+        B .+= B_ .*= Jdensity_correction
+
+    end
+
+    return singularfinish!(B, sing, counts, policy)
+end
+
+
+"""
+    bfield(nodes::AbstractArray, rings::Vector{OrientedRing}; errmax=1e-8, Nt=0, counts=nothing, reorder=Wired.reorder)
+
+Calculate the B-field at a collection of points in 3D space, generated by a series of
+`OrientedRing` objects.
+
+# Arguments
+- `nodes::AbstractArray`: Nx3 `Matrix` containing (x,y,z) coordinates of points in 3D space
+- `rings::Vector{OrientedRing}`: `OrientedRing` objects contributing to the magnetic field
+- `errmax::Float64`: maximum error tolerance for elliptic integral calculations
+- `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+- `counts`: `Vector{Int32}` with one entry per node, to which the number of node/filament pairs at a singularity is added (see `Wired.singularity`)
+- `reorder::Bool`: sort the nodes and sources along a Morton curve for locality before evaluation (default: `Wired.reorder`); the result is in the original order of the nodes
+
+# Returns
+Nx3 `Matrix` containing magnetic flux density vectors at each of the points in 3D space represented by `nodes`
+"""
+function bfield(nodes::AbstractArray{T}, rings::Vector{OrientedRing{S}}; 
+                mu_r=1.0, errmax=1e-8, Nt=0, counts=nothing, reorder::Bool=Wired.reorder) where {T<:Real, S<:AbstractFloat}
+
+    if reorder
+        return inorder(nodes, rings; Nt=Nt, counts=counts) do n, r, c
+            bfield(n, r; mu_r=mu_r, errmax=errmax, Nt=Nt, counts=c, reorder=false)
+        end
+    end
+
+    if T != S 
+        nodes = convert.(S, nodes)
+    end
+
+    Ns = length(rings)
+    if Nt == 0 
+        # Default is to use all available threads
+        Nt = Threads.nthreads()
+    elseif Nt > Threads.nthreads()
+        println("Error. Number of threads specified is greater than available threads.")
+    end
+
+    # Native threading splits the nodes inside the C kernel instead
+    if kernel == "c" && threading == "native"
+        return bs_corientedrings_native(nodes, rings; mu_r=mu_r, Nt=Nt, counts=counts)
+    end
+
+    # Split up the source array across tasks (see sumsources); each task counts the 
+    # singular pairs of its sources separately
+    return sumsources(zeros(S, size(nodes)), Nt, Ns, counts) do idx, c
+        if kernel == "julia"
+            @views biotsavart!(zeros(S, size(nodes)), nodes, rings[idx]; mu_r=mu_r, errmax=errmax, counts=c)
+        elseif kernel == "c"
+            @views bs_corientedrings(nodes, rings[idx]; mu_r=mu_r, counts=c)
+        end
+    end
+end
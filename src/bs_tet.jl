@@ -0,0 +1,186 @@
+""" Wired.jl 
+    Biot-Savart law integration for tetrahedral elements with uniform current density
+"""
+
+"""
+    tetfaces(tet::Tetrahedron)
+
+Determine the outward unit normal and the corners (counter-clockwise about the 
+normal) of each of the four faces of a tetrahedron.
+"""
+function tetfaces(tet::Tetrahedron{T}) where T<:Real
+
+    v = ntuple(k -> tet.nodes[k,:], 4)
+
+    return ntuple(4) do k 
+        # Face k is opposite corner k
+        a, b, c = v[mod1(k+1, 4)], v[mod1(k+2, 4)], v[mod1(k+3, 4)]
+        n = cross(b - a, c - a)
+
+        # Flip the winding if the normal points toward the opposite corner
+        if dot(n, v[k] - a) > 0
+            n = -n 
+            b, c = c, b 
+        end
+
+        (n ./ norm(n), (a, b, c))
+    end
+end
+
+
+"""
+    facepotential(n::SVector, corners::Tuple, r::SVector)
+
+Calculate the integral of 1/|r - r'| over a triangular face with unit normal `n`, 
+for the observation point `r`.
+
+Reference:
+"Potential Integrals for Uniform and Linear Source Distributions on Polygonal
+and Polyhedral Domains", Wilton, Rao, Glisson, Schaubert, Al-Bundak, Butler (1984)
+IEEE Transactions on Antennas and Propagation 32(3)
+"""
+function facepotential(n::SVector{3,T}, corners::NTuple{3,SVector{3,T}}, r::SVector{3,T}) where T<:Real
+
+    # Signed height of the point above the face plane 
+    d = dot(n, r - corners[1])
+    lnsum = zero(T)
+    atsum = zero(T)
+
+    for e in 1:3 
+        p0 = corners[e] - r
+        p1 = corners[mod1(e+1, 3)] - r 
+        len = norm(p1 - p0)
+        s = (p1 - p0) ./ len 
+
+        # Position along the edge of its end points, and distance of the projected 
+        # point from the edge line (positive on the inner side)
+        sm = dot(p0, s)
+        sp = sm + len 
+        t0 = dot(p0, cross(s, n))
+        R02 = t0^2 + d^2
+        Rm = norm(p0)
+        Rp = norm(p1)
+
+        # Both terms vanish on the edge line itself
+        if !(R02 > 0)
+            continue 
+        end
+
+        # R + s, using (R+s)(R-s) = R0^2 to avoid cancellation when s < 0
+        Ap = sp > 0 ? Rp + sp : R02/(Rp - sp)
+        Am = sm > 0 ? Rm + sm : R02/(Rm - sm)
+        lnsum += t0*log(Ap/Am)
+        atsum += atan(t0*sp, R02 + abs(d)*Rp) - atan(t0*sm, R02 + abs(d)*Rm)
+    end
+
+    return lnsum - abs(d)*atsum
+end
+
+
+"""
+    biotsavart!(B::AbstractArray{T}, nodes::AbstractArray{T}, 
+                            tets::AbstractArray{Tetrahedron{T}}; mu_r=1.0) 
+
+Calculate the magnetic flux density generated by a series of tetrahedral elements 
+with uniform current density. 
+
+Modifies an existing output array for the B-field in-place. With uniform current 
+density J, B = mu0/4pi J x g, where g is the integral of (r - r')/|r - r'|^3 over the 
+element. By the divergence theorem, g is the sum over the faces of the face normal 
+times the integral of 1/|r - r'| over the face, which has a closed form. The result 
+is exact both outside and inside the element.
+"""
+function biotsavart!(B::AbstractArray{T}, nodes::AbstractArray{T}, 
+                        tets::AbstractArray{Tetrahedron{T}}; mu_r=1.0) where T<:Real
+
+    d = convert(T, mu_r * mu0 / (4pi))
+
+    for tet in tets
+
+        # Degenerate elements generate no field
+        if !(tetvolume(tet.nodes) > 0)
+            continue 
+        end
+
+        faces = tetfaces(tet)
+        for j in axes(nodes, 1)
+            r = SVector{3,T}(nodes[j,1], nodes[j,2], nodes[j,3])
+            g = sum(n .* facepotential(n, corners, r) for (n, corners) in faces)
+            b = d .* cross(tet.J, g)
+            B[j,1] += b[1]
+            B[j,2] += b[2]
+            B[j,3] += b[3]
+        end
+    end
+
+    return B
+end
+
+
+"""
+    biotsavart(nodes::AbstractArray, tets::AbstractArray{Tetrahedron}; mu_r=1.0)
+
+Calculate the magnetic flux density at points in 3D space generated by a series 
+of tetrahedral elements
+"""
+function biotsavart(nodes::AbstractArray{T}, tets::AbstractArray{Tetrahedron{T}}; 
+                    mu_r=1.0) where T<:Real
+
+    B = zeros(T, size(nodes))
+    biotsavart!(B, nodes, tets; mu_r=mu_r)
+
+    return B 
+end 
+
+
+"""
+    bfield(nodes::AbstractArray, tets::Vector{Tetrahedron}; Nt::Integer=0, mu_r=1.0, reorder=Wired.reorder)
+
+Calculate the B-field at a collection of points in 3D space, generated by a series of
+`Tetrahedron` elements with uniform current density.
+
+# Arguments
+- `nodes::AbstractArray`: Nx3 `Matrix` containing (x,y,z) coordinates of points in 3D space
+- `tets::Vector{Tetrahedron}`: `Tetrahedron` objects contributing to the magnetic field 
+- `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+- `reorder::Bool`: sort the nodes and sources along a Morton curve for locality before evaluation (default: `Wired.reorder`); the result is in the original order of the nodes
+
+# Returns
+Nx3 `Matrix` containing magnetic flux density vectors at each of the points in 3D space represented by `nodes`
+"""
+function bfield(nodes::AbstractArray{T}, tets::Vector{Tetrahedron{S}}; 
+                Nt::Integer=0, mu_r=1.0, reorder::Bool=Wired.reorder) where {T<:Real, S<:AbstractFloat}
+
+    if reorder
+        return inorder(nodes, tets; Nt=Nt) do n, t, c
+            bfield(n, t; Nt=Nt, mu_r=mu_r, reorder=false)
+        end
+    end
+
+    if T != S 
+        nodes = convert.(S, nodes) 
+    end
+
+    Ns = length(tets)
+
+    if Nt == 0 
+        # Default is to use all available threads
+        Nt = Threads.nthreads()
+    elseif Nt > Threads.nthreads()
+        println("Error. Number of threads specified is greater than available threads.")
+    end
+
+    # Native threading splits the nodes inside the C kernel instead
+    if kernel == "c" && threading == "native"
+        return bs_ctets_native(nodes, tets; mu_r=mu_r, Nt=Nt)
+    end
+
+    # Split up the source array across tasks (see sumsources)
+    return sumsources(zeros(S, size(nodes)), Nt, Ns, nothing) do idx, c
+        if kernel == "julia"
+            @views biotsavart(nodes, tets[idx]; mu_r=mu_r)
+        elseif kernel == "c"
+            @views bs_ctets(nodes, tets[idx]; mu_r=mu_r)
+        end
+    end
+end
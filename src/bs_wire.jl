@@ -4,17 +4,18 @@
 
 """
     biotsavart!(B::AbstractArray{T}, nodes::AbstractArray{T}, 
-                            wires::AbstractArray{Wire{T}}; mu_r=1.0) 
+                            wires::AbstractArray{Wire{T}}; mu_r=1.0, counts=nothing) 
 
 Calculate the magnetic flux density generated by a series of current-carrying 
 wire segments. 
 
 Modifies an existing output array for the B-field in-place. Performs a current 
-density correction for node points within the radius of the wire segment. Zeroes 
-out singularity points.
+density correction for node points within the radius of the wire segment. Nodes 
+on the axis of a wire are treated according to `Wired.singularity`, and the number 
+of singular pairs of each node is added to `counts` if given.
 """
 @views function biotsavart!(B::AbstractArray{T}, nodes::AbstractArray{T}, 
-                            wires::AbstractArray{Wire{T}}; mu_r=1.0) where T<:Real
+                            wires::AbstractArray{Wire{T}}; mu_r=1.0, counts=nothing) where T<:Real
 
     # Prefer initializing to zero rather than undef because there's some sort of 
     # assignment stability issue?
@@ -27,6 +28,10 @@ out singularity points.
     norm_b = zeros(T, Nn) 
     d = convert(T, 0.0)
     e = zeros(T, Nn)
+    beyond = falses(Nn); s = falses(Nn)
+    sing = zeros(Int32, Nn)
+    policy = singularpolicy()
+    tol2 = singulartol2(float(T), policy)
 
     # Calculate the effect of each source on all nodes 
     # Linearly superimpose (sum) that effect from all sources
@@ -46,19 +51,28 @@ out singularity points.
         normrows!(norm_b, b)
         rp .= norm_cxa ./ norm(a)
 
+        # Beyond either end (a.c a.b > 0) a.c/|c| - a.b/|b| cancels, so unless the 
+        # policy is "zero" the equivalent form below is used (exact on the axis). 
+        # Nodes on the axis between the end points, or at an end, are singular
+        a2 = dot(a, a)
+        beyond .= (policy != 0) .& (dot_ac .* dot_ab .> 0)
+        s .= .!beyond .& (.!(norm_cxa.^2 .> tol2 .* a2 .* norm_c.^2) .| .!(norm_c .* norm_b .> 0))
+        sing .+= s
+
         # Saving this as its own vector reduces allocations significantly, but 
         # doesn't have an effect on execution time
-        e .= d .* (norm_cxa.^(-2)) .* (dot_ac./norm_c .- dot_ab./norm_b)
+        e .= ifelse.(beyond, d .* (dot_ac .+ dot_ab) ./ (norm_c .* norm_b .* (dot_ac .* norm_b .+ dot_ab .* norm_c)), 
+                     ifelse.(s, zero(T), d .* (norm_cxa.^(-2)) .* (dot_ac./norm_c .- dot_ab./norm_b)))
         multrows!(cxa, e) 
 
-        # Reduce the current density if inside the conductor radius
-        map!(x -> x < R ? (x^2 / R^2) : 1.0, rm, rp)
+        # Reduce the current density if inside the conductor: within radius R 
+        # of the axis and between the end points (0 <= -b.a <= |a|^2)
+        rm .= ifelse.((rp .< R) .& (dot_ab .<= 0) .& (dot_ab .>= -a2), rp.^2 ./ R^2, one(T))
 
         B .+= cxa .* rm
-        map!(x -> isnan(x) ? 0.0 : x, B, B)       # adds 0.4 ms
     end
 
-    return B
+    return singularfinish!(B, sing, counts, policy)
 end
 
 
@@ -69,10 +83,10 @@ Calculate the magnetic flux density at points in 3D space generated by a series
 of finite wire segments
 """
 function biotsavart(nodes::AbstractArray{T}, wires::AbstractArray{Wire{T}}; 
-                    mu_r=1.0) where T<:Real
+                    mu_r=1.0, counts=nothing) where T<:Real
     
     B = zeros(T, size(nodes))
-    biotsavart!(B, nodes, wires; mu_r=mu_r)
+    biotsavart!(B, nodes, wires; mu_r=mu_r, counts=counts)
 
     return B 
 end 
@@ -80,7 +94,7 @@ end
 
 """
     bfield(nodes::AbstractArray, wires::Vector{Wire}; 
-            Nt::Integer=0, mu_r=1.0)
+            Nt::Integer=0, mu_r=1.0, counts=nothing, reorder=Wired.reorder)
 
 Calculate the B-field at a collection of points in 3D space, generated by a series of
 finite-length `Wire` objects.
@@ -89,12 +103,23 @@ finite-length `Wire` objects.
 - `nodes::AbstractArray`: Nx3 `Matrix` containing (x,y,z) coordinates of points in 3D space
 - `wires::Vector{Wire}`: `Wire` objects contributing to the magnetic field 
 - `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+- `counts`: `Vector{Int32}` with one entry per node, to which the number of node/wire pairs at a singularity is added (see `Wired.singularity`)
+- `reorder::Bool`: sort the nodes and sources along a Morton curve for locality before evaluation (default: `Wired.reorder`); the result is in the original order of the nodes
+
+With `Wired.kernel = "c"` and `Wired.threading = "native"`, the nodes (rather than
+the sources) are split across `Nt` threads inside the C kernel; see `kernelstats()`.
 
 # Returns
 Nx3 `Matrix` containing magnetic flux density vectors at each of the points in 3D space represented by `nodes`
 """
 function bfield(nodes::AbstractArray{T}, wires::Vector{Wire{S}}; 
-                Nt::Integer=0, mu_r=1.0) where {T<:Real, S<:AbstractFloat}
+                Nt::Integer=0, mu_r=1.0, counts=nothing, reorder::Bool=Wired.reorder) where {T<:Real, S<:AbstractFloat}
+
+    if reorder
+        return inorder(nodes, wires; Nt=Nt, counts=counts) do n, w, c
+            bfield(n, w; Nt=Nt, mu_r=mu_r, counts=c, reorder=false)
+        end
+    end
 
     if T != S 
         nodes = convert.(S, nodes) 
@@ -109,21 +134,146 @@ function bfield(nodes::AbstractArray{T}, wires::Vector{Wire{S}};
         println("Error. Number of threads specified is greater than available threads.")
     end
 
-    # Spawn a new task for each thread by splitting up the source array
-    tasks = Vector{Task}(undef, Nt)
-    for it = 1:Nt 
+    # Native threading splits the nodes inside the C kernel instead
+    if kernel == "c" && threading == "native"
+        return bs_cwires_native(nodes, wires; mu_r=mu_r, Nt=Nt, counts=counts)
+    end
+
+    # Split up the source array across tasks (see sumsources); each task counts the 
+    # singular pairs of its sources separately
+    return sumsources(zeros(T, size(nodes)), Nt, Ns, counts) do idx, c
         if kernel == "julia"
-            @views tasks[it] = Threads.@spawn biotsavart(nodes, wires[threadindices(it, Nt, Ns)]; mu_r=mu_r)
+            @views biotsavart(nodes, wires[idx]; mu_r=mu_r, counts=c)
         elseif kernel == "c"
-            @views tasks[it] = Threads.@spawn bs_cwires(nodes, wires[threadindices(it, Nt, Ns),:]; mu_r=mu_r)
+            @views bs_cwires(nodes, wires[idx,:]; mu_r=mu_r, counts=c)
         end
     end
-    
-    # Get the result from each calculation and add it to the output array 
-    B = zeros(T, size(nodes))
-    for it = 1:Nt 
-        B .+= fetch(tasks[it]) 
-    end 
+end
+
+
+"""
+    bfield_batch(nodes, wires::Vector{Vector{Wire}}; mu_r=1.0, Nt=0)
+
+Calculate the B-field for many small, independent `Wire` problems in a single call 
+to the C kernel. 
+
+Rather than splitting each problem across threads, whole problems are handed out to 
+the kernel threads as they become free, which keeps the fixed cost per problem low 
+(e.g. when evaluating many candidate coil shapes).
+
+# Arguments
+- `nodes`: either a `Vector` of Nx3 `Matrix`es (one per problem), or a single Nx3 
+    `Matrix` of nodes shared by every problem
+- `wires::Vector{Vector{Wire}}`: the `Wire` objects of each problem
+- `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+
+# Returns
+`Vector` of Nx3 `Matrix`es containing the magnetic flux density of each problem
+"""
+function bfield_batch(nodes::AbstractVector{<:AbstractMatrix}, wires::AbstractVector{<:AbstractVector{Wire{S}}}; 
+                        mu_r=1.0, Nt::Integer=0) where S<:AbstractFloat
+
+    if length(nodes) != length(wires)
+        error("Number of node sets must equal the number of wire sets.")
+    end
+
+    # Each problem gets its own slice of the packed nodes and output
+    problems = Vector{CProblem}(undef, length(wires))
+    n0 = 0
+    w0 = 0
+    for p in eachindex(wires)
+        Nn = size(nodes[p])[1]
+        Nw = length(wires[p])
+        problems[p] = CProblem(w0, Nw, n0, Nn, n0)
+        n0 += Nn 
+        w0 += Nw
+    end
+
+    allnodes = convert.(S, reduce(vcat, nodes))
+    B = bs_cwires_batch(allnodes, reduce(vcat, wires), problems, n0; mu_r=mu_r, 
+                        Nt=(Nt == 0 ? Threads.nthreads() : Nt))
+
+    return [B[p.out0+1:p.out0+p.Nn, :] for p in problems]
+end
+
+function bfield_batch(nodes::AbstractMatrix, wires::AbstractVector{<:AbstractVector{Wire{S}}}; 
+                        mu_r=1.0, Nt::Integer=0) where S<:AbstractFloat
+
+    # Every problem reads the same nodes, but writes its own slice of the output
+    Nn = size(nodes)[1]
+    problems = Vector{CProblem}(undef, length(wires))
+    w0 = 0
+    for (p, w) in enumerate(wires)
+        problems[p] = CProblem(w0, length(w), 0, Nn, (p-1)*Nn)
+        w0 += length(w)
+    end
 
-    return B
-end 
\ No newline at end of file
+    B = bs_cwires_batch(convert.(S, nodes), reduce(vcat, wires), problems, Nn*length(wires); 
+                        mu_r=mu_r, Nt=(Nt == 0 ? Threads.nthreads() : Nt))
+
+    return [B[p.out0+1:p.out0+p.Nn, :] for p in problems]
+end
+
+
+"""
+    bfield_vjp(nodes::AbstractArray, wires::Vector{Wire}, G::AbstractArray; mu_r=1.0, Nt=0)
+
+Calculate the B-field and, in the same pass, the gradient of a scalar objective of 
+the B-field with respect to the parameters of every `Wire` (adjoint mode). 
+
+The cost is the same order as a single `bfield()` call, regardless of the number of 
+parameters. Requires the C kernel, and `Wired.singularity = "zero"` (node/wire pairs 
+on the wire axis add nothing). 
+
+# Arguments
+- `nodes::AbstractArray`: Nx3 `Matrix` containing (x,y,z) coordinates of points in 3D space
+- `wires::Vector{Wire}`: `Wire` objects contributing to the magnetic field 
+- `G::AbstractArray`: Nx3 `Matrix` containing the derivative of the objective with 
+    respect to B at each node
+- `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+
+# Returns
+- Nx3 `Matrix` containing the magnetic flux density at each node 
+- Nw x 7 `Matrix` containing the gradient of the objective with respect to 
+    `(a0x, a0y, a0z, a1x, a1y, a1z, I)` of each `Wire`
+"""
+function bfield_vjp(nodes::AbstractArray{T}, wires::Vector{Wire{S}}, G::AbstractArray; 
+                    mu_r=1.0, Nt::Integer=0) where {T<:Real, S<:AbstractFloat}
+
+    if size(G) != size(nodes)
+        error("Size of objective derivative matrix unequal to nodes matrix.")
+    end
+    checkzeropolicy("bfield_vjp")
+
+    B, grad = bs_cwires_vjp(convert.(S, nodes), wires, convert.(S, G); mu_r=mu_r, 
+                            Nt=(Nt == 0 ? Threads.nthreads() : Nt))
+
+    return B, permutedims(grad)
+end
+
+
+"""
+    bfield_jacobian(nodes::AbstractArray, wires::Vector{Wire}; mu_r=1.0, Nt=0)
+
+Calculate the B-field and, in the same pass, its derivatives with respect to the 
+parameters of every `Wire` (forward sensitivity mode). 
+
+The result has `21*Nn*Nw` entries, so this is only practical for small problems; use 
+`bfield_vjp()` for gradients of a scalar objective. Requires the C kernel, and 
+`Wired.singularity = "zero"`.
+
+# Returns
+- Nx3 `Matrix` containing the magnetic flux density at each node 
+- Nn x 3 x Nw x 7 `Array` `J`, where `J[j,m,i,k]` is the derivative of component `m` 
+    of B at node `j` with respect to parameter `k` of `Wire` `i`, in the order 
+    `(a0x, a0y, a0z, a1x, a1y, a1z, I)`
+"""
+function bfield_jacobian(nodes::AbstractArray{T}, wires::Vector{Wire{S}}; 
+                    mu_r=1.0, Nt::Integer=0) where {T<:Real, S<:AbstractFloat}
+
+    checkzeropolicy("bfield_jacobian")
+    B, J = bs_cwires_jacobian(convert.(S, nodes), wires; mu_r=mu_r, 
+                              Nt=(Nt == 0 ? Threads.nthreads() : Nt))
+
+    return B, permutedims(J, (4, 3, 2, 1))
+end
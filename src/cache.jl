@@ -0,0 +1,138 @@
+""" Wired.jl
+    Persistent, content-addressed cache of B-field evaluations
+"""
+
+# Each cache file holds the (x, y, z, Bx, By, Bz) records computed so far for one
+# set of sources and options, after a fixed header
+const cachemagic = b"WIREDBF1"
+const cacheheader = 24
+
+
+"""
+    cachekey(sources; kwargs...)
+
+SHA-256 (hex string) of everything that determines the B-field generated by
+`sources` at a given point: the source parameters (not their names), the options
+passed to `bfield` (except `Nt` and `reorder`), `Wired.kernel`,
+`Wired.check_inside`, `Wired.singularity` and the package version.
+"""
+function cachekey(sources::Vector{<:Source}; kwargs...)
+    io = IOBuffer()
+    write(io, "Wired $version kernel=$kernel check_inside=$check_inside singularity=$(singularitymode())\n")
+    for (k, v) in sort([(string(k), v) for (k, v) in kwargs if !(k in (:Nt, :reorder))])
+        write(io, "$k=$(repr(v))\n")
+    end
+
+    for s in sources
+        write(io, string(typeof(s)), "\n")
+        for f in fieldnames(typeof(s))
+            v = getfield(s, f)
+            if !isa(v, AbstractString)
+                write(io, v)
+            end
+        end
+    end
+
+    return bytes2hex(sha256(take!(io)))
+end
+
+
+"""
+    readcache(path)
+
+Memory-map a cache file as a 6xN `Matrix` of (x, y, z, Bx, By, Bz) records.
+"""
+function readcache(path::AbstractString)
+    open(path, "r") do io
+        magic = read(io, length(cachemagic))
+        if magic != cachemagic
+            error("$path is not a Wired.jl cache file.")
+        end
+        T = (read(io, Int64) == 4) ? Float32 : Float64
+        N = read(io, Int64)
+        return Mmap.mmap(io, Matrix{T}, (6, N), cacheheader; grow=false)
+    end
+end
+
+
+"""
+    writecache(path, records)
+
+Write a 6xN `Matrix` of records to a cache file. The file is written under a
+temporary name and then moved into place, so concurrent readers only ever see a
+complete file.
+"""
+function writecache(path::AbstractString, records::AbstractMatrix{T}) where T<:AbstractFloat
+    tmp = path * ".$(getpid()).tmp"
+    open(tmp, "w") do io
+        write(io, cachemagic)
+        write(io, Int64(sizeof(T)))
+        write(io, Int64(size(records, 2)))
+        write(io, records)
+    end
+    mv(tmp, path; force=true)
+end
+
+
+"""
+    bfield_cached(nodes, sources; cachedir=Wired.cachedir, kwargs...)
+
+Calculate the B-field like `bfield(nodes, sources; kwargs...)`, reusing results
+stored on disk by earlier calls with the same sources and options (see `cachekey`).
+
+Points already in the cache are read from a memory-mapped file without calling the
+kernel; only the remaining points are calculated, and are then added to the cache.
+Points are matched exactly (bit for bit), in the precision of the sources. With an
+empty `cachedir` (the default), this is the same as `bfield`.
+"""
+function bfield_cached(nodes::AbstractMatrix{<:Real}, sources::Vector{<:Source};
+                        cachedir::AbstractString=Wired.cachedir, kwargs...)
+
+    if isempty(cachedir)
+        return bfield(nodes, sources; kwargs...)
+    end
+
+    mkpath(cachedir)
+    path = joinpath(cachedir, cachekey(sources; kwargs...) * ".bin")
+    Nn = size(nodes, 1)
+
+    # Look every point up in the records already stored
+    if isfile(path)
+        records = readcache(path)
+        T = eltype(records)
+        index = Dict{NTuple{3, T}, Int}()
+        for j in axes(records, 2)
+            index[(records[1,j], records[2,j], records[3,j])] = j
+        end
+        found = [get(index, NTuple{3, T}(nodes[i,:]), 0) for i in 1:Nn]
+    else
+        records = nothing
+        found = zeros(Int, Nn)
+    end
+
+    todo = findall(==(0), found)
+    if isempty(todo)
+        return permutedims(records[4:6, found])
+    end
+
+    # Calculate the new points only, then merge them into the cache
+    Bnew = bfield(nodes[todo,:], sources; kwargs...)
+    T = eltype(Bnew)
+    newnodes = convert.(T, nodes[todo,:])
+    seen = Set{NTuple{3, T}}()
+    keep = [!(Tuple(r) in seen) && (push!(seen, Tuple(r)); true) for r in eachrow(newnodes)]
+    new = permutedims(hcat(newnodes, Bnew)[keep,:])
+    if isnothing(records)
+        writecache(path, new)
+    else
+        writecache(path, hcat(convert.(T, records), new))
+    end
+
+    B = zeros(T, Nn, 3)
+    B[todo,:] = Bnew
+    hit = findall(>(0), found)
+    if !isempty(hit)
+        B[hit,:] = permutedims(records[4:6, found[hit]])
+    end
+    return B
+end
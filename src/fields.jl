@@ -48,4 +48,129 @@ struct Line{T<:Real} <: Field
     function Line(start::Vector{<:Real}, stop::Vector{<:Real}, N::Integer)
         Line{precision}(start, stop, N)
     end
-end
\ No newline at end of file
+end
+
+
+"""
+    struct Grid <: Field
+
+A structured grid of points in 3D space, stored as its first point, the step along 
+each grid axis and the number of points along each axis: point (i,j,k) is 
+`origin + (i-1)*steps[:,1] + (j-1)*steps[:,2] + (k-1)*steps[:,3]`. 
+
+The points are never stored. The C kernel generates them as it goes, which keeps very 
+large field maps (10^8 points) within memory. Results are returned as an Nx3 `Matrix` 
+with the first index varying fastest, i.e. `reshape(B, size(grid)..., 3)`.
+
+Use `CartesianGrid` (a box) or `PlaneGrid` (a plane in any orientation) to build one.
+
+# Fields 
+- `origin::SVector{3}`: first point of the grid
+- `steps::SMatrix{3,3}`: column m is the step between points along grid axis m
+- `dims::NTuple{3,Int}`: number of points along each grid axis
+"""
+struct Grid{T<:Real} <: Field 
+
+    origin::SVector{3, T}
+    steps::SMatrix{3, 3, T, 9}
+    dims::NTuple{3, Int}
+
+    function Grid{T}(origin::AbstractVector{<:Real}, steps::AbstractMatrix{<:Real}, dims) where T<:Real
+        new(convert.(T, origin), convert.(T, steps), Tuple(Int.(dims)))
+    end
+end
+
+Grid{T}(grid::Grid) where T<:Real = Grid{T}(grid.origin, grid.steps, grid.dims)
+Base.size(grid::Grid) = grid.dims
+
+
+"""
+    CartesianGrid(x::AbstractRange, y::AbstractRange, z::AbstractRange)
+
+Axis-aligned box of points with the coordinates in `x`, `y` and `z`, e.g. 
+`CartesianGrid(range(0, 1, 101), range(-1, 1, 201), 0:0.01:0.5)`.
+"""
+function CartesianGrid(x::AbstractRange, y::AbstractRange, z::AbstractRange)
+    steps = [step(x) 0 0; 0 step(y) 0; 0 0 step(z)]
+    Grid{precision}([first(x), first(y), first(z)], steps, (length(x), length(y), length(z)))
+end
+
+
+"""
+    PlaneGrid(origin, u, v, Nu, Nv)
+
+Plane of `Nu` x `Nv` points in any orientation, spanning the parallelogram with 
+corners `origin`, `origin + u`, `origin + v` and `origin + u + v`.
+"""
+function PlaneGrid(origin::Vector{<:Real}, u::Vector{<:Real}, v::Vector{<:Real}, Nu::Integer, Nv::Integer)
+    steps = hcat(u ./ max(Nu - 1, 1), v ./ max(Nv - 1, 1), zeros(3))
+    Grid{precision}(origin, steps, (Nu, Nv, 1))
+end
+
+
+"""
+    struct CylindricalGrid <: Field
+
+A structured grid of points in cylindrical coordinates about the Z-axis: point (i,j,k) 
+is at radius `r[i]`, azimuth `phi[j]` and height `z[k]`. As for `Grid`, the points are 
+never stored, results are returned with the first index varying fastest, and coaxial 
+`Ring` sources are evaluated once per (r, z) by the C kernel.
+
+# Fields 
+- `r0`, `dr`: first radius and radial step
+- `phi0`, `dphi`: first azimuth and azimuthal step [rad]
+- `z0`, `dz`: first height and vertical step 
+- `dims::NTuple{3,Int}`: number of points in r, phi and z
+"""
+struct CylindricalGrid{T<:Real} <: Field 
+
+    r0::T
+    dr::T
+    phi0::T
+    dphi::T
+    z0::T
+    dz::T
+    dims::NTuple{3, Int}
+
+    function CylindricalGrid{T}(r::AbstractRange, phi::AbstractRange, z::AbstractRange) where T<:Real
+        new(first(r), step(r), first(phi), step(phi), first(z), step(z), (length(r), length(phi), length(z)))
+    end
+
+    function CylindricalGrid{T}(grid::CylindricalGrid) where T<:Real
+        new(grid.r0, grid.dr, grid.phi0, grid.dphi, grid.z0, grid.dz, grid.dims)
+    end
+
+    # Convenience constructor for using Wired.precision
+    function CylindricalGrid(r::AbstractRange, phi::AbstractRange, z::AbstractRange)
+        CylindricalGrid{precision}(r, phi, z)
+    end
+end
+
+Base.size(grid::CylindricalGrid) = grid.dims
+
+
+"""
+    fieldnodes(field::Field)
+
+Nx3 `Matrix` of the points of a `Field`. Only needed where the points are not 
+generated by the kernel (e.g. the Julia kernel).
+"""
+fieldnodes(line::Line) = line.nodes
+
+function fieldnodes(grid::Grid{T}) where T<:Real
+    nodes = Matrix{T}(undef, prod(grid.dims), 3)
+    for (n, I) in enumerate(CartesianIndices(grid.dims))
+        nodes[n,:] = grid.origin .+ grid.steps * SVector{3, T}(I[1]-1, I[2]-1, I[3]-1)
+    end
+    return nodes
+end
+
+function fieldnodes(grid::CylindricalGrid{T}) where T<:Real
+    nodes = Matrix{T}(undef, prod(grid.dims), 3)
+    for (n, I) in enumerate(CartesianIndices(grid.dims))
+        r = grid.r0 + (I[1]-1)*grid.dr
+        phi = grid.phi0 + (I[2]-1)*grid.dphi
+        nodes[n,:] = [r*cos(phi), r*sin(phi), grid.z0 + (I[3]-1)*grid.dz]
+    end
+    return nodes
+end
@@ -0,0 +1,231 @@
+""" Wired.jl
+    Sources driven by several sets of currents (time-harmonic, multi-harmonic or
+    multi-phase excitation) in a single geometric pass
+"""
+
+
+"""
+    biotsavart_multi!(B::AbstractArray{T,3}, nodes::AbstractArray{T}, wires::AbstractArray{Wire{T}},
+                        I::AbstractMatrix; mu_r=1.0)
+
+Add the field of `wires` driven by each column of `I` (length(wires) x M) to the
+Nx3xM array `B`. The field per unit current of each wire is calculated once and
+scaled by its M currents; the currents of the `Wire` objects are ignored. Nodes on
+the axis of a wire are treated according to `Wired.singularity`.
+"""
+@views function biotsavart_multi!(B::AbstractArray{T,3}, nodes::AbstractArray{T},
+                                  wires::AbstractArray{Wire{T}}, I::AbstractMatrix; mu_r=1.0) where T<:Real
+
+    Nn = size(nodes)[1]
+    b = zeros(T, Nn,3); c = zeros(T, Nn,3); cxa = zeros(T, Nn, 3)
+    rp = zeros(T, Nn); rm = zeros(T, Nn)
+    a = zeros(T, 3)
+    norm_cxa = zeros(T, Nn); dot_ac = zeros(T, Nn)
+    norm_c = zeros(T, Nn); dot_ab = zeros(T, Nn)
+    norm_b = zeros(T, Nn)
+    e = zeros(T, Nn)
+    d = convert(T, mu_r * mu0 / (4pi))
+    beyond = falses(Nn); s = falses(Nn)
+    sing = zeros(Int32, Nn)
+    policy = singularpolicy()
+    tol2 = singulartol2(float(T), policy)
+
+    for (i, wire) in enumerate(wires)
+
+        a .= wire.a1 .- wire.a0
+        b .= wire.a0' .- nodes
+        c .= wire.a1' .- nodes
+        R = wire.R
+
+        crossrows!(cxa, c, a)
+        normrows!(norm_cxa, cxa)
+        dotrows!(dot_ac, c, a)
+        dotrows!(dot_ab, b, a)
+        normrows!(norm_c, c)
+        normrows!(norm_b, b)
+        rp .= norm_cxa ./ norm(a)
+
+        # Stable form beyond the ends and singular pairs, as in biotsavart!
+        a2 = dot(a, a)
+        beyond .= (policy != 0) .& (dot_ac .* dot_ab .> 0)
+        s .= .!beyond .& (.!(norm_cxa.^2 .> tol2 .* a2 .* norm_c.^2) .| .!(norm_c .* norm_b .> 0))
+        sing .+= s
+        e .= ifelse.(beyond, d .* (dot_ac .+ dot_ab) ./ (norm_c .* norm_b .* (dot_ac .* norm_b .+ dot_ab .* norm_c)), 
+                     ifelse.(s, zero(T), d .* (norm_cxa.^(-2)) .* (dot_ac./norm_c .- dot_ab./norm_b)))
+        multrows!(cxa, e)
+
+        # Reduce the current density if inside the conductor
+        rm .= ifelse.((rp .< R) .& (dot_ab .<= 0) .& (dot_ab .>= -a2), rp.^2 ./ R^2, one(T))
+        multrows!(cxa, rm)
+
+        for m in axes(I, 2)
+            B[:,:,m] .+= convert(T, I[i,m]) .* cxa
+        end
+    end
+
+    return singularfinish!(B, sing, nothing, policy)
+end
+
+
+"""
+    biotsavart_multi!(B::AbstractArray{T,3}, nodes::AbstractArray{T}, rings::AbstractArray{CircularRing{T}},
+                        I::AbstractMatrix; mu_r=1.0, errmax=1e-8)
+
+Add the field of `rings` driven by each column of `I` (length(rings) x M) to the
+Nx3xM array `B`, with one evaluation of the elliptic integrals per node and ring.
+The currents of the `CircularRing` objects are ignored, and nodes on a filament are
+treated according to `Wired.singularity`.
+"""
+@views function biotsavart_multi!(B::AbstractArray{T,3}, nodes::AbstractArray{T},
+                                  rings::AbstractArray{CircularRing{T}}, I::AbstractMatrix;
+                                  mu_r=1.0, errmax=1e-8) where T<:Real
+
+    Nnodes = size(nodes)[1]
+    B_ = zeros(T, Nnodes, 3)
+    r = zeros(T, Nnodes)
+    alpha = zeros(T, Nnodes)
+    a2 = zeros(T, Nnodes)
+    beta = zeros(T, Nnodes)
+    k2 = zeros(T, Nnodes)
+    E = zeros(T, Nnodes)
+    K = zeros(T, Nnodes)
+    Jdensity_correction = zeros(T, Nnodes)
+    g = zeros(T, Nnodes)
+    s = falses(Nnodes)
+    sing = zeros(Int32, Nnodes)
+    policy = singularpolicy()
+    tol2 = singulartol2(T, policy)
+    rho = sqrt.(nodes[:,1].^2 .+ nodes[:,2].^2)
+    irho2 = ifelse.(rho .> 0, 1 ./ rho.^2, zero(T))
+    C = mu_r * mu0 / pi
+
+    for (i, ring) in enumerate(rings)
+
+        a = ring.R
+        r .= sqrt.(nodes[:,1].^2 .+ nodes[:,2].^2 .+ (nodes[:,3] .- ring.H).^2)
+        a2 .= (rho .- a).^2 .+ (nodes[:,3] .- ring.H).^2
+        alpha .= sqrt.(a2)
+        beta .= sqrt.(a^2 .+ r.^2 .+ 2 .* a .*rho)
+        s .= .!(a2 .> tol2 .* beta.^2)
+        sing .+= s
+        k2 .= ifelse.(s, zero(T), 1 .- a2./(beta.^2))
+
+        K .= ellipK.(k2; errmax=errmax)
+        E .= ellipE.(k2; errmax=errmax)
+
+        # Field per unit current
+        g .= ifelse.(s, zero(T), C ./ (2 .* a2 .* beta))
+        B_[:,1] .= (g .* nodes[:,1] .* (nodes[:,3] .- ring.H) .* irho2) .* ((a^2 .+ r.^2) .* E .- a2.*K)
+        B_[:,2] .= (g .* nodes[:,2] .* (nodes[:,3] .- ring.H) .* irho2) .* ((a^2 .+ r.^2) .* E .- a2.*K)
+        B_[:,3] .= g .* ((a.^2 .- r.^2) .* E .+ a2 .* K)
+
+        map!(x -> x < ring.r ? (x^2)/ring.r^2 : 1.0, Jdensity_correction, alpha)
+        B_ .*= Jdensity_correction
+
+        for m in axes(I, 2)
+            B[:,:,m] .+= convert(T, I[i,m]) .* B_
+        end
+    end
+
+    return singularfinish!(B, sing, nothing, policy)
+end
+
+
+# Field of a chunk of sources with their rows of the currents, with either kernel
+function multichunk(nodes::AbstractArray{T}, wires::AbstractArray{Wire{T}}, I::AbstractMatrix;
+                    mu_r=1.0, errmax=1e-8) where T<:Real
+    if kernel == "c"
+        return bs_cwires_multi(nodes, wires, I; mu_r=mu_r)
+    end
+    return biotsavart_multi!(zeros(T, size(nodes, 1), 3, size(I, 2)), nodes, wires, I; mu_r=mu_r)
+end
+
+function multichunk(nodes::AbstractArray{T}, rings::AbstractArray{CircularRing{T}}, I::AbstractMatrix;
+                    mu_r=1.0, errmax=1e-8) where T<:Real
+    if kernel == "c"
+        return bs_crings_multi(nodes, rings, I; mu_r=mu_r)
+    end
+    return biotsavart_multi!(zeros(T, size(nodes, 1), 3, size(I, 2)), nodes, rings, I;
+                             mu_r=mu_r, errmax=errmax)
+end
+
+
+"""
+    bfield_multi(nodes, sources, I::AbstractMatrix; mu_r=1.0, Nmin=2, errmax=1e-8, Nt=0)
+
+Calculate the B-field generated by the same `Wire`, `CircularRing` or `RectangularRing`
+sources driven by several sets of currents, e.g. the phases of a three-phase system
+or the harmonics of a periodic excitation. Column m of `I` (length(sources) x M)
+holds the current of each source in set m; the currents stored in the sources are
+ignored.
+
+The geometry of every node/source pair (including the elliptic integrals of rings)
+is calculated once and scaled by all M currents, so M sets cost little more than one
+`bfield` call. `RectangularRing`'s are split into `CircularRing`'s with `makecircrings`
+(with both kernels), sharing the current of their ring evenly. The sources are split
+across `Nt` Julia threads.
+
+# Returns
+Nx3xM `Array`: the magnetic flux density at each of the `nodes` for each set of currents
+"""
+function bfield_multi(nodes::AbstractArray{T}, sources::Union{Vector{Wire{S}}, Vector{CircularRing{S}}},
+                      I::AbstractMatrix{<:Real}; mu_r=1.0, Nmin=2, errmax=1e-8, Nt=0) where {T<:Real, S<:AbstractFloat}
+
+    if T != S
+        nodes = convert.(S, nodes)
+    end
+
+    Ns = length(sources)
+    size(I, 1) == Ns || error("The currents must have one row per source.")
+
+    if Nt == 0
+        Nt = Threads.nthreads()
+    elseif Nt > Threads.nthreads()
+        println("Error. Number of threads specified is greater than available threads.")
+    end
+
+    # Split up the sources (and their currents) across tasks (see sumsources)
+    return sumsources(zeros(S, size(nodes, 1), 3, size(I, 2)), Nt, Ns, nothing) do idx, c
+        @views multichunk(nodes, sources[idx], I[idx,:]; mu_r=mu_r, errmax=errmax)
+    end
+end
+
+function bfield_multi(nodes::AbstractArray{<:Real}, rect::Vector{RectangularRing{S}}, I::AbstractMatrix{<:Real};
+                      Nmin=2, kwargs...) where S<:AbstractFloat
+
+    size(I, 1) == length(rect) || error("The currents must have one row per source.")
+
+    # Each filament carries an equal share of the currents of its ring
+    circ = Vector{CircularRing{S}}(undef, 0)
+    rows = Vector{Int}(undef, 0)
+    share = Vector{Float64}(undef, 0)
+    for i in eachindex(rect)
+        fil = makecircrings(rect[i:i], Nmin)
+        append!(circ, fil)
+        append!(rows, fill(i, length(fil)))
+        append!(share, fill(1/length(fil), length(fil)))
+    end
+
+    return bfield_multi(nodes, circ, I[rows,:] .* share; Nmin=Nmin, kwargs...)
+end
+
+
+"""
+    bfield_multi(nodes, sources, I::AbstractVecOrMat{<:Complex}; kwargs...)
+
+Time-harmonic field of `sources` driven by phasor currents `I` (one per source, or
+length(sources) x M for several frequencies or load cases). The real and imaginary
+parts are evaluated together as 2M sets of currents.
+
+# Returns
+Complex Nx3 `Matrix` of field phasors at each of the `nodes` (Nx3xM `Array` if `I` is a `Matrix`)
+"""
+function bfield_multi(nodes::AbstractArray{<:Real}, sources::Vector{<:Source}, I::AbstractMatrix{<:Complex}; kwargs...)
+    M = size(I, 2)
+    B = bfield_multi(nodes, sources, hcat(real(I), imag(I)); kwargs...)
+    return complex.(B[:,:,1:M], B[:,:,M+1:2M])
+end
+
+function bfield_multi(nodes::AbstractArray{<:Real}, sources::Vector{<:Source}, I::AbstractVector{<:Complex}; kwargs...)
+    return bfield_multi(nodes, sources, reshape(I, :, 1); kwargs...)[:,:,1]
+end
@@ -29,28 +29,190 @@ struct CRing64
 	I::Cdouble 
 end
 
+struct COrientedRing32
+	c::NTuple{3, Cfloat}
+	n::NTuple{3, Cfloat}
+	R::Cfloat 
+	r::Cfloat 
+	I::Cfloat 
+end
+
+struct COrientedRing64
+	c::NTuple{3, Cdouble}
+	n::NTuple{3, Cdouble}
+	R::Cdouble 
+	r::Cdouble 
+	I::Cdouble 
+end
+
+struct CRectRing32
+	H::Cfloat 
+	R::Cfloat 
+	w::Cfloat 
+	h::Cfloat 
+	I::Cfloat 
+end
+
+struct CRectRing64
+	H::Cdouble 
+	R::Cdouble 
+	w::Cdouble 
+	h::Cdouble 
+	I::Cdouble 
+end
+
+struct CTet32
+	v::NTuple{12, Cfloat}
+	J::NTuple{3, Cfloat}
+end
+
+struct CTet64
+	v::NTuple{12, Cdouble}
+	J::NTuple{3, Cdouble}
+end
+
+# Match the Grid and CylindricalGrid definitions in the C kernel
+struct CGrid32
+	o::NTuple{3, Cfloat}
+	e::NTuple{9, Cfloat}
+	n::NTuple{3, Cint}
+end
+
+struct CGrid64
+	o::NTuple{3, Cdouble}
+	e::NTuple{9, Cdouble}
+	n::NTuple{3, Cint}
+end
+
+struct CCylindricalGrid32
+	v::NTuple{6, Cfloat}
+	n::NTuple{3, Cint}
+end
+
+struct CCylindricalGrid64
+	v::NTuple{6, Cdouble}
+	n::NTuple{3, Cint}
+end
+
+# Match the ParallelOptions definition in the C kernel
+struct ParallelOptions
+	Nt::Cint
+	firsttouch::Cint
+	pin::Cint
+	socketaware::Cint
+end
+
+# Match the ThreadStats definition in the C kernel
+struct ThreadStats
+	cpu::Cint
+	node::Cint
+	n0::Cint
+	n1::Cint
+	elapsed::Cdouble
+end
+
+# Match the Reduction definition in the C kernel (see reduce.h)
+struct CReduction
+	wsum::Cdouble
+	Bsum::NTuple{3, Cdouble}
+	B1::Cdouble
+	B2::Cdouble
+	flux::Cdouble
+	max::Cdouble
+	min::Cdouble
+	argmax::Clonglong
+	argmin::Clonglong
+	nsing::Clonglong
+	nflagged::Clonglong
+end
+
+# Match the Problem definition in the C kernel
+struct CProblem
+	wire0::Cint
+	Nw::Cint
+	node0::Cint
+	Nn::Cint
+	out0::Cint
+end
+
+"""
+	struct KernelStats
+
+Instrumentation for a natively-threaded C kernel call (`Wired.threading = "native"`)
+
+# Fields 
+- `threads::Vector{ThreadStats}`: core, NUMA node, node range (0-based, half-open) 
+	and time spent in the kernel for each thread
+- `sockets::Int`: number of distinct NUMA nodes the threads ran on 
+- `firsttouch::Bool`: whether node/output partitions were first-touched by their thread
+- `pinned::Bool`: whether threads were pinned to cores
+- `socketaware::Bool`: whether node partitions were grouped by NUMA node
+- `elapsed::Float64`: wall-clock time of the kernel call [s]
+"""
+struct KernelStats
+	threads::Vector{ThreadStats}
+	sockets::Int
+	firsttouch::Bool
+	pinned::Bool
+	socketaware::Bool
+	elapsed::Float64
+end
+
+laststats = nothing
+
+"""
+	kernelstats()
+
+Return the `KernelStats` of the most recent natively-threaded C kernel call, or 
+`nothing` if there has not been one yet.
+"""
+kernelstats() = laststats
+
 wires_sp = string(@__DIR__)*"/kernel/"*"wires_sp.so"
 wires_dp = string(@__DIR__)*"/kernel/"*"wires_dp.so"
 rings_sp = string(@__DIR__)*"/kernel/"*"rings_sp.so"
 rings_dp = string(@__DIR__)*"/kernel/"*"rings_dp.so"
+tets_sp = string(@__DIR__)*"/kernel/"*"tets_sp.so"
+tets_dp = string(@__DIR__)*"/kernel/"*"tets_dp.so"
+reference = string(@__DIR__)*"/kernel/"*"reference.so"
 
 """ 
-	installkernel()
+	installkernel(; reproducible=false)
 
 Install the C kernel by compiling using gcc/make commands
+
+With `reproducible`, the kernel is built with strict IEEE arithmetic and without 
+FMA contraction (instead of `-ffast-math`), so every operation is rounded the same 
+way in vector and scalar code and on any instruction set: its results do not 
+depend on the number of threads or on the machine (given the same C math library). 
+It was 0-6% slower in benchmarks. A kernel that has already been loaded is only replaced 
+in a new Julia session.
 """
-function installkernel()
+function installkernel(; reproducible::Bool=false)
 	current_directory = @__DIR__
 	cd(current_directory*"/kernel")
-	run(`make`);
+	run(`make -B REPRO=$(Int(reproducible))`);
 	cd(current_directory)
 end
 
 
+"""
+	kernelreproducible()
+
+Whether the installed C kernel was built for reproducible results (see 
+`installkernel` and `Wired.reproducible`).
+"""
+function kernelreproducible()
+	kernelguard()
+	return (@ccall wires_dp.kernel_reproducible()::Cint) == 1
+end
+
+
 function checkifkernelinstalled()
 	# See if its there
 
-	if isfile(wires_sp) && isfile(wires_dp) && isfile(rings_sp) && isfile(rings_dp)
+	if (isfile(wires_sp) && isfile(wires_dp) && isfile(rings_sp) && isfile(rings_dp) && 
+		isfile(tets_sp) && isfile(tets_dp) && isfile(reference))
 		return true 
 	else
 		return false 
@@ -64,6 +226,24 @@ function kernelguard()
 	end 
 end
 
+# Throw if a C kernel call returned a nonzero status (it could not allocate its 
+# working memory), rather than return a result it only partly wrote
+function kernelstatus(status::Integer, name::AbstractString)
+	if status != 0
+		error("C kernel call $name failed with status $status (out of memory).")
+	end
+end
+
+# Per-node counts of singular pairs for the C kernel (see singular.h), which the 
+# kernel adds to; C_NULL if they are not wanted
+function singularcounts(counts, Nn::Integer)
+	isnothing(counts) && return C_NULL
+	if !isa(counts, Vector{Int32}) || length(counts) != Nn
+		error("The singular pair counts must be a Vector{Int32} with one entry per node.")
+	end
+	return counts
+end
+
 
 """
 	convertCWires(wires::Vector{Wire{Float32}})
@@ -135,12 +315,121 @@ function convertCRings(rings::AbstractArray{CircularRing{Float64}})
 	return crings
 end
 
+"""
+	convertCOrientedRings(rings::Vector{OrientedRing{Float32}})
+
+Convert OrientedRing objects to COrientedRing objects.
+"""
+function convertCOrientedRings(rings::AbstractArray{OrientedRing{Float32}})
+	N = length(rings)
+	crings = Vector{COrientedRing32}(undef, N)
+	for i in 1:N 
+		crings[i] = COrientedRing32(Tuple(rings[i].center), Tuple(rings[i].normal), 
+									rings[i].R, rings[i].r, rings[i].I)
+	end
+	
+	return crings
+end
+
+"""
+	convertCOrientedRings(rings::Vector{OrientedRing{Float64}})
+
+Convert OrientedRing objects to COrientedRing objects.
+"""
+function convertCOrientedRings(rings::AbstractArray{OrientedRing{Float64}})
+	N = length(rings)
+	crings = Vector{COrientedRing64}(undef, N)
+	for i in 1:N 
+		crings[i] = COrientedRing64(Tuple(rings[i].center), Tuple(rings[i].normal), 
+									rings[i].R, rings[i].r, rings[i].I)
+	end
+	
+	return crings
+end
+
+"""
+	convertCRectRings(rings::Vector{RectangularRing{Float32}})
+
+Convert RectangularRing objects to CRectRing objects.
+"""
+function convertCRectRings(rings::AbstractArray{RectangularRing{Float32}})
+	N = length(rings)
+	crings = Vector{CRectRing32}(undef, N)
+	for i = 1:N
+		crings[i] = CRectRing32(rings[i].H, rings[i].R, rings[i].w, rings[i].h, rings[i].I)
+	end
+
+	return crings
+end
+
+
+"""
+	convertCRectRings(rings::Vector{RectangularRing{Float64}})
+
+Convert RectangularRing objects to CRectRing objects.
+"""
+function convertCRectRings(rings::AbstractArray{RectangularRing{Float64}})
+	N = length(rings)
+	crings = Vector{CRectRing64}(undef, N)
+	for i = 1:N
+		crings[i] = CRectRing64(rings[i].H, rings[i].R, rings[i].w, rings[i].h, rings[i].I)
+	end
+
+	return crings
+end
+
+
+"""
+	convertCGrid(grid::Grid)
+
+Convert a Grid or CylindricalGrid to its C kernel definition.
+"""
+convertCGrid(grid::Grid{Float32}) = CGrid32(Tuple(grid.origin), Tuple(grid.steps), Int32.(grid.dims))
+convertCGrid(grid::Grid{Float64}) = CGrid64(Tuple(grid.origin), Tuple(grid.steps), Int32.(grid.dims))
+convertCGrid(grid::CylindricalGrid{Float32}) = CCylindricalGrid32((grid.r0, grid.dr, grid.phi0, grid.dphi, grid.z0, grid.dz), Int32.(grid.dims))
+convertCGrid(grid::CylindricalGrid{Float64}) = CCylindricalGrid64((grid.r0, grid.dr, grid.phi0, grid.dphi, grid.z0, grid.dz), Int32.(grid.dims))
+
+
+"""
+	convertCTets(tets::Vector{Tetrahedron{Float32}})
+
+Convert Tetrahedron objects to CTet objects (corner nodes in row-major order).
+"""
+function convertCTets(tets::AbstractArray{Tetrahedron{Float32}})
+	N = length(tets)
+	ctets = Vector{CTet32}(undef, N)
+	for i in 1:N 
+		ctets[i] = CTet32(ntuple(k -> tets[i].nodes[div(k-1, 3)+1, mod(k-1, 3)+1], 12), 
+						(tets[i].J[1], tets[i].J[2], tets[i].J[3]))
+	end
+	
+	return ctets
+end
+
+
+"""
+	convertCTets(tets::Vector{Tetrahedron{Float64}})
+
+Convert Tetrahedron objects to CTet objects (corner nodes in row-major order).
+"""
+function convertCTets(tets::AbstractArray{Tetrahedron{Float64}})
+	N = length(tets)
+	ctets = Vector{CTet64}(undef, N)
+	for i in 1:N 
+		ctets[i] = CTet64(ntuple(k -> tets[i].nodes[div(k-1, 3)+1, mod(k-1, 3)+1], 12), 
+						(tets[i].J[1], tets[i].J[2], tets[i].J[3]))
+	end
+	
+	return ctets
+end
+
+
 """
 	bs_cwire(nodes::AbstractArray{Float32}, wires::Vector{Wire{Float32}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 """
 function bs_cwires(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 
 	kernelguard()
 
@@ -166,6 +455,8 @@ function bs_cwires(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Floa
 	else
 		check = 0.0f0
 	end
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
 
 	@ccall wires_sp.bfield_wires(Bx_ptr::Ptr{Float32}, 
 								   By_ptr::Ptr{Float32}, 
@@ -177,21 +468,19 @@ function bs_cwires(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Floa
 								   Nn::Int32, 
 								   Nw::Int32, 
 								   mu_r::Float32, 
-								   check::Int32)::Cvoid
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cvoid
 	
-	# Zero out singularity points
-	map!(x -> isnan(x) ? 0.0 : x, Bx, Bx)
-	map!(x -> isnan(x) ? 0.0 : x, By, By)
-	map!(x -> isnan(x) ? 0.0 : x, Bz, Bz)
 	return hcat(Bx, By, Bz)
 end 
 
 """
 	bs_cwire(nodes::AbstractArray{Float64}, wires::Vector{Wire{Float64}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 """
 function bs_cwires(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 
 	kernelguard()
 
@@ -217,6 +506,8 @@ function bs_cwires(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Floa
 	else
 		check = 0.0f0
 	end
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
 
 	@ccall wires_dp.bfield_wires(Bx_ptr::Ptr{Float64}, 
 								   By_ptr::Ptr{Float64}, 
@@ -228,22 +519,20 @@ function bs_cwires(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Floa
 								   Nn::Int64, 
 								   Nw::Int64, 
 								   mu_r::Float64, 
-								   check::Int64)::Cvoid
+								   check::Int64,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cvoid
 	
-	# Zero out singularity points
-	map!(x -> isnan(x) ? 0.0 : x, Bx, Bx)
-	map!(x -> isnan(x) ? 0.0 : x, By, By)
-	map!(x -> isnan(x) ? 0.0 : x, Bz, Bz)
 	return hcat(Bx, By, Bz)
 end 
 
 
 """
 	bs_rings!(nodes::AbstractArray{Float32}, wires::Vector{Wire{Float32}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 """
 function bs_crings(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 
 	kernelguard()
 
@@ -269,6 +558,8 @@ function bs_crings(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularR
 	else
 		check = 0.0f0
 	end
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
 
 	@ccall rings_sp.bfield_rings(Bx_ptr::Ptr{Float32}, 
 								   By_ptr::Ptr{Float32}, 
@@ -280,22 +571,20 @@ function bs_crings(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularR
 								   Nn::Int32, 
 								   Nr::Int32, 
 								   mu_r::Float32, 
-								   check::Int32)::Cvoid
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cvoid
 	
-	# Zero out singularity points
-	map!(x -> isnan(x) ? 0.0 : x, Bx, Bx)
-	map!(x -> isnan(x) ? 0.0 : x, By, By)
-	map!(x -> isnan(x) ? 0.0 : x, Bz, Bz)
-	# return hcat(Bx, By, Bz)
+	return hcat(Bx, By, Bz)
 end 
 
 
 """
 	bs_rings!(nodes::AbstractArray{Float64}, rings::Vector{Wire{Float64}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 """
 function bs_crings(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}};
-					mu_r=1.0)
+					mu_r=1.0, counts=nothing)
 
 	kernelguard()
 
@@ -321,8 +610,10 @@ function bs_crings(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularR
 	else
 		check = 0.0f0
 	end
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
 
-	@ccall rings_sp.bfield_rings(Bx_ptr::Ptr{Float64}, 
+	@ccall rings_dp.bfield_rings(Bx_ptr::Ptr{Float64}, 
 								   By_ptr::Ptr{Float64}, 
 								   Bz_ptr::Ptr{Float64}, 
 								   x_ptr::Ptr{Float64},
@@ -332,11 +623,1718 @@ function bs_crings(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularR
 								   Nn::Int32, 
 								   Nr::Int32, 
 								   mu_r::Float64, 
-								   check::Int32)::Cvoid
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cvoid
 	
-	# Zero out singularity points
-	map!(x -> isnan(x) ? 0.0 : x, Bx, Bx)
-	map!(x -> isnan(x) ? 0.0 : x, By, By)
-	map!(x -> isnan(x) ? 0.0 : x, Bz, Bz)
-	# return hcat(Bx, By, Bz)
-end 
\ No newline at end of file
+	return hcat(Bx, By, Bz)
+end 
+
+
+"""
+	nativeoptions(Nt::Integer)
+
+Collect the native threading options (see `Wired.threading`) for a kernel call 
+using `Nt` threads, along with the core list and an output buffer for statistics.
+"""
+function nativeoptions(Nt::Integer)
+
+	opts = Ref(ParallelOptions(Nt, numa_firsttouch, pin_threads, socket_aware))
+
+	if isempty(cpulist)
+		cpus = collect(Cint, 0:Nt-1)
+	elseif length(cpulist) < Nt
+		error("Wired.cpulist has fewer cores than the number of threads requested.")
+	else
+		cpus = convert.(Cint, cpulist)
+	end
+
+	stats = Vector{ThreadStats}(undef, Nt)
+
+	return opts, cpus, stats
+end
+
+
+"""
+	recordstats(stats::Vector{ThreadStats}, elapsed::Real)
+
+Store the instrumentation for the most recent native kernel call.
+"""
+function recordstats(stats::Vector{ThreadStats}, elapsed::Real)
+
+	active = filter(s -> s.n1 > s.n0, stats)
+	sockets = length(unique(s.node for s in active))
+	global laststats = KernelStats(stats, sockets, numa_firsttouch, pin_threads, 
+									socket_aware, elapsed)
+end
+
+
+"""
+	bs_cwires_native(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_cwires_native(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(wires))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	csources = convertCWires(wires)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall wires_sp.bfield_wires_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{CWire32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_wires_parallel")
+
+	return B
+end
+
+
+"""
+	bs_cwires_native(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_cwires_native(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(wires))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	csources = convertCWires(wires)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall wires_dp.bfield_wires_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CWire64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_wires_parallel")
+
+	return B
+end
+
+
+"""
+	bs_crings_native(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_crings_native(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	csources = convertCRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall rings_sp.bfield_rings_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{CRing32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_rings_parallel")
+
+	return B
+end
+
+
+"""
+	bs_crings_native(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_crings_native(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	csources = convertCRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall rings_dp.bfield_rings_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CRing64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_rings_parallel")
+
+	return B
+end
+
+
+"""
+	bs_cwires_batch(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}, 
+					problems::Vector{CProblem}, Nout::Integer; mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Solve a batch of independent problems, packed into shared node/wire buffers, in one 
+call to the C kernel. Returns the packed Nout x 3 output.
+"""
+function bs_cwires_batch(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}, 
+							problems::Vector{CProblem}, Nout::Integer; mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Np = convert(Int32, length(problems))
+	Bx = Vector{Float32}(undef, Nout)
+	By = Vector{Float32}(undef, Nout)
+	Bz = Vector{Float32}(undef, Nout)
+	mu_r = convert(Float32, mu_r)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nout)
+
+	status = @ccall wires_sp.bfield_wires_batch(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   cwires::Ptr{CWire32},
+								   problems::Ptr{CProblem},
+								   Np::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   Nt::Int32)::Cint
+	kernelstatus(status, "bfield_wires_batch")
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_cwires_batch(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}, 
+					problems::Vector{CProblem}, Nout::Integer; mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Solve a batch of independent problems, packed into shared node/wire buffers, in one 
+call to the C kernel. Returns the packed Nout x 3 output.
+"""
+function bs_cwires_batch(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}, 
+							problems::Vector{CProblem}, Nout::Integer; mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Np = convert(Int32, length(problems))
+	Bx = Vector{Float64}(undef, Nout)
+	By = Vector{Float64}(undef, Nout)
+	Bz = Vector{Float64}(undef, Nout)
+	mu_r = convert(Float64, mu_r)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nout)
+
+	status = @ccall wires_dp.bfield_wires_batch(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   cwires::Ptr{CWire64},
+								   problems::Ptr{CProblem},
+								   Np::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   Nt::Int32)::Cint
+	kernelstatus(status, "bfield_wires_batch")
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_cwires_vjp(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}, 
+					G::AbstractArray{Float32}; mu_r=1.0, Nt=Threads.nthreads())
+
+Adjoint mode of the C kernel: B and the vector-Jacobian product of `G` (Nn x 3) with 
+dB/d(wire parameters), as a 7 x Nw matrix.
+"""
+function bs_cwires_vjp(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}, 
+						G::AbstractArray{Float32}; mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nw = convert(Int32, length(wires))
+	Bx = Vector{Float32}(undef, Nn)
+	By = Vector{Float32}(undef, Nn)
+	Bz = Vector{Float32}(undef, Nn)
+	grad = Matrix{Float32}(undef, 7, Nw)
+	mu_r = convert(Float32, mu_r)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+
+	status = @ccall wires_sp.bfield_wires_vjp(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   cwires::Ptr{CWire32},
+								   Nn::Int32, 
+								   Nw::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   (@view G[:,1])::Ptr{Float32},
+								   (@view G[:,2])::Ptr{Float32},
+								   (@view G[:,3])::Ptr{Float32},
+								   grad::Ptr{Float32},
+								   Nt::Int32)::Cint
+	kernelstatus(status, "bfield_wires_vjp")
+
+	return hcat(Bx, By, Bz), grad
+end
+
+
+"""
+	bs_cwires_jacobian(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}; 
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Forward sensitivity mode of the C kernel: B and dB/d(wire parameters), as a 
+7 x Nw x 3 x Nn array.
+"""
+function bs_cwires_jacobian(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}; 
+							mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nw = convert(Int32, length(wires))
+	Bx = Vector{Float32}(undef, Nn)
+	By = Vector{Float32}(undef, Nn)
+	Bz = Vector{Float32}(undef, Nn)
+	J = Array{Float32}(undef, 7, Nw, 3, Nn)
+	mu_r = convert(Float32, mu_r)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+
+	status = @ccall wires_sp.bfield_wires_jacobian(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   cwires::Ptr{CWire32},
+								   Nn::Int32, 
+								   Nw::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   J::Ptr{Float32},
+								   Nt::Int32)::Cint
+	kernelstatus(status, "bfield_wires_jacobian")
+
+	return hcat(Bx, By, Bz), J
+end
+
+
+"""
+	bs_cwires_vjp(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}, 
+					G::AbstractArray{Float64}; mu_r=1.0, Nt=Threads.nthreads())
+
+Adjoint mode of the C kernel: B and the vector-Jacobian product of `G` (Nn x 3) with 
+dB/d(wire parameters), as a 7 x Nw matrix.
+"""
+function bs_cwires_vjp(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}, 
+						G::AbstractArray{Float64}; mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nw = convert(Int32, length(wires))
+	Bx = Vector{Float64}(undef, Nn)
+	By = Vector{Float64}(undef, Nn)
+	Bz = Vector{Float64}(undef, Nn)
+	grad = Matrix{Float64}(undef, 7, Nw)
+	mu_r = convert(Float64, mu_r)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+
+	status = @ccall wires_dp.bfield_wires_vjp(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   cwires::Ptr{CWire64},
+								   Nn::Int32, 
+								   Nw::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   (@view G[:,1])::Ptr{Float64},
+								   (@view G[:,2])::Ptr{Float64},
+								   (@view G[:,3])::Ptr{Float64},
+								   grad::Ptr{Float64},
+								   Nt::Int32)::Cint
+	kernelstatus(status, "bfield_wires_vjp")
+
+	return hcat(Bx, By, Bz), grad
+end
+
+
+"""
+	bs_cwires_jacobian(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}; 
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Forward sensitivity mode of the C kernel: B and dB/d(wire parameters), as a 
+7 x Nw x 3 x Nn array.
+"""
+function bs_cwires_jacobian(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}; 
+							mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nw = convert(Int32, length(wires))
+	Bx = Vector{Float64}(undef, Nn)
+	By = Vector{Float64}(undef, Nn)
+	Bz = Vector{Float64}(undef, Nn)
+	J = Array{Float64}(undef, 7, Nw, 3, Nn)
+	mu_r = convert(Float64, mu_r)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+
+	status = @ccall wires_dp.bfield_wires_jacobian(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   cwires::Ptr{CWire64},
+								   Nn::Int32, 
+								   Nw::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   J::Ptr{Float64},
+								   Nt::Int32)::Cint
+	kernelstatus(status, "bfield_wires_jacobian")
+
+	return hcat(Bx, By, Bz), J
+end
+
+
+"""
+	bs_ctets(nodes::AbstractArray{Float32}, tets::AbstractArray{Tetrahedron{Float32}};
+					mu_r=1.0)
+"""
+function bs_ctets(nodes::AbstractArray{Float32}, tets::AbstractArray{Tetrahedron{Float32}};
+					mu_r=1.0)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ne = convert(Int32, length(tets))
+	Bx = zeros(Float32, Nn)
+	By = zeros(Float32, Nn)
+	Bz = zeros(Float32, Nn)
+	mu_r = convert(Float32, mu_r)
+	csources = convertCTets(tets)
+
+	@ccall tets_sp.bfield_tets(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{CTet32},
+								   Nn::Int32, 
+								   Ne::Int32, 
+								   mu_r::Float32)::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_ctets_native(nodes::AbstractArray{Float32}, tets::AbstractArray{Tetrahedron{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_ctets_native(nodes::AbstractArray{Float32}, tets::AbstractArray{Tetrahedron{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(tets))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	csources = convertCTets(tets)
+	opts, cpus, stats = nativeoptions(Nt)
+
+	t0 = time()
+	status = @ccall tets_sp.bfield_tets_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{CTet32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float32, 
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_tets_parallel")
+
+	return B
+end
+
+
+"""
+	bs_ctets(nodes::AbstractArray{Float64}, tets::AbstractArray{Tetrahedron{Float64}};
+					mu_r=1.0)
+"""
+function bs_ctets(nodes::AbstractArray{Float64}, tets::AbstractArray{Tetrahedron{Float64}};
+					mu_r=1.0)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ne = convert(Int32, length(tets))
+	Bx = zeros(Float64, Nn)
+	By = zeros(Float64, Nn)
+	Bz = zeros(Float64, Nn)
+	mu_r = convert(Float64, mu_r)
+	csources = convertCTets(tets)
+
+	@ccall tets_dp.bfield_tets(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CTet64},
+								   Nn::Int32, 
+								   Ne::Int32, 
+								   mu_r::Float64)::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_ctets_native(nodes::AbstractArray{Float64}, tets::AbstractArray{Tetrahedron{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_ctets_native(nodes::AbstractArray{Float64}, tets::AbstractArray{Tetrahedron{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(tets))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	csources = convertCTets(tets)
+	opts, cpus, stats = nativeoptions(Nt)
+
+	t0 = time()
+	status = @ccall tets_dp.bfield_tets_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CTet64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float64, 
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_tets_parallel")
+
+	return B
+end
+
+
+"""
+	bs_corientedrings(nodes::AbstractArray{Float32}, rings::AbstractArray{OrientedRing{Float32}};
+					mu_r=1.0, counts=nothing)
+"""
+function bs_corientedrings(nodes::AbstractArray{Float32}, rings::AbstractArray{OrientedRing{Float32}};
+					mu_r=1.0, counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nr = convert(Int32, length(rings))
+	Bx = zeros(Float32, Nn)
+	By = zeros(Float32, Nn)
+	Bz = zeros(Float32, Nn)
+	mu_r = convert(Float32, mu_r)
+	csources = convertCOrientedRings(rings)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	@ccall rings_sp.bfield_oriented_rings(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{COrientedRing32},
+								   Nn::Int32, 
+								   Nr::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_corientedrings_native(nodes::AbstractArray{Float32}, rings::AbstractArray{OrientedRing{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_corientedrings_native(nodes::AbstractArray{Float32}, rings::AbstractArray{OrientedRing{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	csources = convertCOrientedRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall rings_sp.bfield_oriented_rings_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{COrientedRing32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_oriented_rings_parallel")
+
+	return B
+end
+
+
+"""
+	bs_corientedrings(nodes::AbstractArray{Float64}, rings::AbstractArray{OrientedRing{Float64}};
+					mu_r=1.0, counts=nothing)
+"""
+function bs_corientedrings(nodes::AbstractArray{Float64}, rings::AbstractArray{OrientedRing{Float64}};
+					mu_r=1.0, counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nr = convert(Int32, length(rings))
+	Bx = zeros(Float64, Nn)
+	By = zeros(Float64, Nn)
+	Bz = zeros(Float64, Nn)
+	mu_r = convert(Float64, mu_r)
+	csources = convertCOrientedRings(rings)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	@ccall rings_dp.bfield_oriented_rings(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{COrientedRing64},
+								   Nn::Int32, 
+								   Nr::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_corientedrings_native(nodes::AbstractArray{Float64}, rings::AbstractArray{OrientedRing{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_corientedrings_native(nodes::AbstractArray{Float64}, rings::AbstractArray{OrientedRing{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	csources = convertCOrientedRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall rings_dp.bfield_oriented_rings_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{COrientedRing64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_oriented_rings_parallel")
+
+	return B
+end
+
+"""
+	bs_crectrings(nodes::AbstractArray{Float32}, rings::AbstractArray{RectangularRing{Float32}};
+					mu_r=1.0, errmax=1e-8)
+
+Rectangular cross-sections are integrated directly in the kernel, with a quadrature
+rule chosen per node to meet the relative error `errmax`.
+"""
+function bs_crectrings(nodes::AbstractArray{Float32}, rings::AbstractArray{RectangularRing{Float32}};
+					mu_r=1.0, errmax=1e-8)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nr = convert(Int32, length(rings))
+	Bx = zeros(Float32, Nn)
+	By = zeros(Float32, Nn)
+	Bz = zeros(Float32, Nn)
+	mu_r = convert(Float32, mu_r)
+	tol = convert(Float32, errmax)
+	csources = convertCRectRings(rings)
+
+	@ccall rings_sp.bfield_rect_rings(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{CRectRing32},
+								   Nn::Int32, 
+								   Nr::Int32, 
+								   mu_r::Float32, 
+								   tol::Float32)::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_crectrings_native(nodes::AbstractArray{Float32}, rings::AbstractArray{RectangularRing{Float32}};
+					mu_r=1.0, errmax=1e-8, Nt=Threads.nthreads())
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_crectrings_native(nodes::AbstractArray{Float32}, rings::AbstractArray{RectangularRing{Float32}};
+					mu_r=1.0, errmax=1e-8, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	tol = convert(Float32, errmax)
+	csources = convertCRectRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+
+	t0 = time()
+	status = @ccall rings_sp.bfield_rect_rings_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   csources::Ptr{CRectRing32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float32, 
+								   tol::Float32,
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_rect_rings_parallel")
+
+	return B
+end
+
+"""
+	bs_crectrings(nodes::AbstractArray{Float64}, rings::AbstractArray{RectangularRing{Float64}};
+					mu_r=1.0, errmax=1e-8)
+
+Rectangular cross-sections are integrated directly in the kernel, with a quadrature
+rule chosen per node to meet the relative error `errmax`.
+"""
+function bs_crectrings(nodes::AbstractArray{Float64}, rings::AbstractArray{RectangularRing{Float64}};
+					mu_r=1.0, errmax=1e-8)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nr = convert(Int32, length(rings))
+	Bx = zeros(Float64, Nn)
+	By = zeros(Float64, Nn)
+	Bz = zeros(Float64, Nn)
+	mu_r = convert(Float64, mu_r)
+	tol = convert(Float64, errmax)
+	csources = convertCRectRings(rings)
+
+	@ccall rings_dp.bfield_rect_rings(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CRectRing64},
+								   Nn::Int32, 
+								   Nr::Int32, 
+								   mu_r::Float64, 
+								   tol::Float64)::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_crectrings_native(nodes::AbstractArray{Float64}, rings::AbstractArray{RectangularRing{Float64}};
+					mu_r=1.0, errmax=1e-8, Nt=Threads.nthreads())
+
+Natively-threaded C kernel: nodes are split across `Nt` OpenMP threads.
+"""
+function bs_crectrings_native(nodes::AbstractArray{Float64}, rings::AbstractArray{RectangularRing{Float64}};
+					mu_r=1.0, errmax=1e-8, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# partition of every column
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	tol = convert(Float64, errmax)
+	csources = convertCRectRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+
+	t0 = time()
+	status = @ccall rings_dp.bfield_rect_rings_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CRectRing64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   mu_r::Float64, 
+								   tol::Float64,
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_rect_rings_parallel")
+
+	return B
+end
+
+"""
+	bs_cwires_grid(grid::Grid{Float32}, wires::AbstractArray{Wire{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel for Grid targets: grid rows are split across `Nt` OpenMP 
+threads, and the grid points are generated in the kernel.
+"""
+function bs_cwires_grid(grid::Grid{Float32}, wires::AbstractArray{Wire{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = prod(grid.dims)
+	Nw = convert(Int32, length(wires))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# rows of every column
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	cgrid = convertCGrid(grid)
+	cwires = convertCWires(wires)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall wires_sp.bfield_wires_grid_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   cgrid::Ref{CGrid32},
+								   cwires::Ptr{CWire32},
+								   Nw::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_wires_grid_parallel")
+
+	return B
+end
+
+
+"""
+	bs_crings_cylgrid(grid::CylindricalGrid{Float32}, rings::AbstractArray{CircularRing{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Natively-threaded C kernel for CylindricalGrid targets: the field of the (coaxial) 
+rings is evaluated once per (r, z) and rotated to every azimuth.
+"""
+function bs_crings_cylgrid(grid::CylindricalGrid{Float32}, rings::AbstractArray{CircularRing{Float32}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = prod(grid.dims)
+	Nr = convert(Int32, length(rings))
+	B = Matrix{Float32}(undef, Nn, 3)
+	mu_r = convert(Float32, mu_r)
+	cgrid = convertCGrid(grid)
+	crings = convertCRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+
+	t0 = time()
+	status = @ccall rings_sp.bfield_rings_cylgrid_parallel((@view B[:,1])::Ptr{Float32}, 
+								   (@view B[:,2])::Ptr{Float32}, 
+								   (@view B[:,3])::Ptr{Float32}, 
+								   cgrid::Ref{CCylindricalGrid32},
+								   crings::Ptr{CRing32},
+								   Nr::Int32, 
+								   mu_r::Float32, 
+								   check::Int32,
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_rings_cylgrid_parallel")
+
+	return B
+end
+
+"""
+	bs_cwires_grid(grid::Grid{Float64}, wires::AbstractArray{Wire{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+Natively-threaded C kernel for Grid targets: grid rows are split across `Nt` OpenMP 
+threads, and the grid points are generated in the kernel.
+"""
+function bs_cwires_grid(grid::Grid{Float64}, wires::AbstractArray{Wire{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads(), counts=nothing)
+
+	kernelguard()
+
+	Nn = prod(grid.dims)
+	Nw = convert(Int32, length(wires))
+	# Left uninitialized and returned as is: each kernel thread first-touches its own 
+	# rows of every column
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	cgrid = convertCGrid(grid)
+	cwires = convertCWires(wires)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	t0 = time()
+	status = @ccall wires_dp.bfield_wires_grid_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   cgrid::Ref{CGrid64},
+								   cwires::Ptr{CWire64},
+								   Nw::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32},
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_wires_grid_parallel")
+
+	return B
+end
+
+
+"""
+	bs_crings_cylgrid(grid::CylindricalGrid{Float64}, rings::AbstractArray{CircularRing{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Natively-threaded C kernel for CylindricalGrid targets: the field of the (coaxial) 
+rings is evaluated once per (r, z) and rotated to every azimuth.
+"""
+function bs_crings_cylgrid(grid::CylindricalGrid{Float64}, rings::AbstractArray{CircularRing{Float64}};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = prod(grid.dims)
+	Nr = convert(Int32, length(rings))
+	B = Matrix{Float64}(undef, Nn, 3)
+	mu_r = convert(Float64, mu_r)
+	cgrid = convertCGrid(grid)
+	crings = convertCRings(rings)
+	opts, cpus, stats = nativeoptions(Nt)
+	check = check_inside ? Int32(1) : Int32(0)
+
+	t0 = time()
+	status = @ccall rings_dp.bfield_rings_cylgrid_parallel((@view B[:,1])::Ptr{Float64}, 
+								   (@view B[:,2])::Ptr{Float64}, 
+								   (@view B[:,3])::Ptr{Float64}, 
+								   cgrid::Ref{CCylindricalGrid64},
+								   crings::Ptr{CRing64},
+								   Nr::Int32, 
+								   mu_r::Float64, 
+								   check::Int32,
+								   opts::Ref{ParallelOptions},
+								   cpus::Ptr{Cint},
+								   stats::Ptr{ThreadStats})::Cint
+	recordstats(stats, time() - t0)
+	kernelstatus(status, "bfield_rings_cylgrid_parallel")
+
+	return B
+end
+
+
+"""
+	convertCFilaments(rings::Vector{RectangularRing{Float32}}, order::Integer)
+
+Replace RectangularRing objects by the `order` x `order` Gauss-Legendre points of 
+their cross-sections (2, 4, 8 or 16 per side), as CRing filaments carrying the 
+quadrature weight of the current.
+"""
+function convertCFilaments(rings::AbstractArray{RectangularRing{Float32}}, order::Integer)
+
+	q = findfirst(==(order), (2, 4, 8, 16))
+	if isnothing(q)
+		error("Cross-section quadrature order must be 2, 4, 8 or 16.")
+	end
+
+	kernelguard()
+
+	Nr = convert(Int32, length(rings))
+	filaments = Vector{CRing32}(undef, Nr*order^2)
+	csources = convertCRectRings(rings)
+
+	@ccall rings_sp.rect_filaments(filaments::Ptr{CRing32}, 
+								   csources::Ptr{CRectRing32},
+								   Nr::Int32, 
+								   Int32(q-1)::Int32)::Cint
+
+	return filaments
+end
+
+
+"""
+	bs_cringforces(filaments::AbstractArray{CRing32}, start::AbstractArray{Int32};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Pairwise axial forces, hoop loads and axial stiffness between coils of coaxial 
+filaments, the filaments of coil i being `filaments[start[i]+1:start[i+1]]`. Filaments 
+are split across `Nt` OpenMP threads.
+"""
+function bs_cringforces(filaments::AbstractArray{CRing32}, start::AbstractArray{Int32};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nc = convert(Int32, length(start) - 1)
+	Fz = zeros(Float32, Nc, Nc)
+	Fr = zeros(Float32, Nc, Nc)
+	K = zeros(Float32, Nc, Nc)
+	mu_r = convert(Float32, mu_r)
+	Nt = convert(Int32, Nt)
+
+	status = @ccall rings_sp.ring_forces(Fz::Ptr{Float32}, 
+								   Fr::Ptr{Float32}, 
+								   K::Ptr{Float32}, 
+								   filaments::Ptr{CRing32},
+								   start::Ptr{Int32},
+								   Nc::Int32, 
+								   mu_r::Float32, 
+								   Nt::Int32)::Cint
+	kernelstatus(status, "ring_forces")
+
+	return Fz, Fr, K
+end
+
+
+"""
+	convertCFilaments(rings::Vector{RectangularRing{Float64}}, order::Integer)
+
+Replace RectangularRing objects by the `order` x `order` Gauss-Legendre points of 
+their cross-sections (2, 4, 8 or 16 per side), as CRing filaments carrying the 
+quadrature weight of the current.
+"""
+function convertCFilaments(rings::AbstractArray{RectangularRing{Float64}}, order::Integer)
+
+	q = findfirst(==(order), (2, 4, 8, 16))
+	if isnothing(q)
+		error("Cross-section quadrature order must be 2, 4, 8 or 16.")
+	end
+
+	kernelguard()
+
+	Nr = convert(Int32, length(rings))
+	filaments = Vector{CRing64}(undef, Nr*order^2)
+	csources = convertCRectRings(rings)
+
+	@ccall rings_dp.rect_filaments(filaments::Ptr{CRing64}, 
+								   csources::Ptr{CRectRing64},
+								   Nr::Int32, 
+								   Int32(q-1)::Int32)::Cint
+
+	return filaments
+end
+
+
+"""
+	bs_cringforces(filaments::AbstractArray{CRing64}, start::AbstractArray{Int32};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+Pairwise axial forces, hoop loads and axial stiffness between coils of coaxial 
+filaments, the filaments of coil i being `filaments[start[i]+1:start[i+1]]`. Filaments 
+are split across `Nt` OpenMP threads.
+"""
+function bs_cringforces(filaments::AbstractArray{CRing64}, start::AbstractArray{Int32};
+					mu_r=1.0, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nc = convert(Int32, length(start) - 1)
+	Fz = zeros(Float64, Nc, Nc)
+	Fr = zeros(Float64, Nc, Nc)
+	K = zeros(Float64, Nc, Nc)
+	mu_r = convert(Float64, mu_r)
+	Nt = convert(Int32, Nt)
+
+	status = @ccall rings_dp.ring_forces(Fz::Ptr{Float64}, 
+								   Fr::Ptr{Float64}, 
+								   K::Ptr{Float64}, 
+								   filaments::Ptr{CRing64},
+								   start::Ptr{Int32},
+								   Nc::Int32, 
+								   mu_r::Float64, 
+								   Nt::Int32)::Cint
+	kernelstatus(status, "ring_forces")
+
+	return Fz, Fr, K
+end
+
+
+"""
+	bs_reference(nodes::AbstractArray, wires::AbstractArray{<:Wire}; mu_r=1.0)
+
+Extended-precision (long double) reference kernel, built without fast-math, for 
+validating the other kernels. Inputs are converted to Float64, and the field is 
+returned in Float64.
+"""
+function bs_reference(nodes::AbstractArray{<:Real}, wires::AbstractArray{<:Wire}; mu_r=1.0)
+
+	kernelguard()
+
+	nodes = convert.(Float64, nodes)
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(wires))
+	Bx = zeros(Float64, Nn)
+	By = zeros(Float64, Nn)
+	Bz = zeros(Float64, Nn)
+	csources = [CWire64(Float64.(Tuple(w.a0)), Float64.(Tuple(w.a1)), w.I, w.R) for w in wires]
+	check = check_inside ? Int32(1) : Int32(0)
+
+	@ccall reference.bfield_wires_ref(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CWire64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   Float64(mu_r)::Float64, 
+								   check::Int32)::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_reference(nodes::AbstractArray, rings::AbstractArray{<:CircularRing}; mu_r=1.0)
+
+Extended-precision (long double) reference kernel for `CircularRing` sources.
+"""
+function bs_reference(nodes::AbstractArray{<:Real}, rings::AbstractArray{<:CircularRing}; mu_r=1.0)
+
+	kernelguard()
+
+	nodes = convert.(Float64, nodes)
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	Bx = zeros(Float64, Nn)
+	By = zeros(Float64, Nn)
+	Bz = zeros(Float64, Nn)
+	csources = [CRing64(r.H, r.R, r.r, r.I) for r in rings]
+	check = check_inside ? Int32(1) : Int32(0)
+
+	@ccall reference.bfield_rings_ref(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   csources::Ptr{CRing64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   Float64(mu_r)::Float64, 
+								   check::Int32)::Cint
+
+	return hcat(Bx, By, Bz)
+end
+
+
+"""
+	bs_cwires_multi(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+
+Field of `wires` driven by each column of `I` (length(wires) x M), from a single 
+pass over the geometry. Returns an Nx3xM `Array`.
+"""
+function bs_cwires_multi(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nw = convert(Int32, length(wires))
+	M = convert(Int32, size(I, 2))
+	Bx = zeros(Float32, Nn, M)
+	By = zeros(Float32, Nn, M)
+	Bz = zeros(Float32, Nn, M)
+	currents = Matrix{Float32}(I)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	@ccall wires_sp.bfield_wires_multi(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   cwires::Ptr{CWire32},
+								   currents::Ptr{Float32},
+								   Nn::Int32, 
+								   Nw::Int32, 
+								   M::Int32, 
+								   Float32(mu_r)::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cint
+
+	return permutedims(cat(Bx, By, Bz; dims=3), (1, 3, 2))
+end
+
+
+"""
+	bs_cwires_multi(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+"""
+function bs_cwires_multi(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nw = convert(Int32, length(wires))
+	M = convert(Int32, size(I, 2))
+	Bx = zeros(Float64, Nn, M)
+	By = zeros(Float64, Nn, M)
+	Bz = zeros(Float64, Nn, M)
+	currents = Matrix{Float64}(I)
+	cwires = convertCWires(wires)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	@ccall wires_dp.bfield_wires_multi(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   cwires::Ptr{CWire64},
+								   currents::Ptr{Float64},
+								   Nn::Int32, 
+								   Nw::Int32, 
+								   M::Int32, 
+								   Float64(mu_r)::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cint
+
+	return permutedims(cat(Bx, By, Bz; dims=3), (1, 3, 2))
+end
+
+
+"""
+	bs_crings_multi(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+
+Field of `rings` driven by each column of `I` (length(rings) x M), evaluating the 
+elliptic integrals once. Returns an Nx3xM `Array`.
+"""
+function bs_crings_multi(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nr = convert(Int32, length(rings))
+	M = convert(Int32, size(I, 2))
+	Bx = zeros(Float32, Nn, M)
+	By = zeros(Float32, Nn, M)
+	Bz = zeros(Float32, Nn, M)
+	currents = Matrix{Float32}(I)
+	crings = convertCRings(rings)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	@ccall rings_sp.bfield_rings_multi(Bx::Ptr{Float32}, 
+								   By::Ptr{Float32}, 
+								   Bz::Ptr{Float32}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   crings::Ptr{CRing32},
+								   currents::Ptr{Float32},
+								   Nn::Int32, 
+								   Nr::Int32, 
+								   M::Int32, 
+								   Float32(mu_r)::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cint
+
+	return permutedims(cat(Bx, By, Bz; dims=3), (1, 3, 2))
+end
+
+
+"""
+	bs_crings_multi(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+"""
+function bs_crings_multi(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}}, 
+					I::AbstractMatrix; mu_r=1.0, counts=nothing)
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Nr = convert(Int32, length(rings))
+	M = convert(Int32, size(I, 2))
+	Bx = zeros(Float64, Nn, M)
+	By = zeros(Float64, Nn, M)
+	Bz = zeros(Float64, Nn, M)
+	currents = Matrix{Float64}(I)
+	crings = convertCRings(rings)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	nsing = singularcounts(counts, Nn)
+
+	@ccall rings_dp.bfield_rings_multi(Bx::Ptr{Float64}, 
+								   By::Ptr{Float64}, 
+								   Bz::Ptr{Float64}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   crings::Ptr{CRing64},
+								   currents::Ptr{Float64},
+								   Nn::Int32, 
+								   Nr::Int32, 
+								   M::Int32, 
+								   Float64(mu_r)::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   nsing::Ptr{Int32})::Cint
+
+	return permutedims(cat(Bx, By, Bz; dims=3), (1, 3, 2))
+end
+
+
+"""
+	bs_cmortonorder(points::AbstractMatrix{Float32}; Nt=Threads.nthreads())
+
+Permutation that sorts Nx3 `points` along a Morton curve, from the parallel radix 
+sort of the C kernel over `Nt` OpenMP threads.
+"""
+function bs_cmortonorder(points::AbstractMatrix{Float32}; Nt=Threads.nthreads())
+
+	kernelguard()
+
+	N = convert(Int32, size(points)[1])
+	perm = Vector{Int32}(undef, N)
+
+	@ccall wires_sp.morton_sort(perm::Ptr{Int32}, 
+								   (@view points[:,1])::Ptr{Float32},
+								   (@view points[:,2])::Ptr{Float32},
+								   (@view points[:,3])::Ptr{Float32}, 
+								   N::Int32, 
+								   Int32(Nt)::Int32)::Cint
+
+	return Int.(perm) .+ 1
+end
+
+
+"""
+	bs_cmortonorder(points::AbstractMatrix{Float64}; Nt=Threads.nthreads())
+"""
+function bs_cmortonorder(points::AbstractMatrix{Float64}; Nt=Threads.nthreads())
+
+	kernelguard()
+
+	N = convert(Int32, size(points)[1])
+	perm = Vector{Int32}(undef, N)
+
+	@ccall wires_dp.morton_sort(perm::Ptr{Int32}, 
+								   (@view points[:,1])::Ptr{Float64},
+								   (@view points[:,2])::Ptr{Float64},
+								   (@view points[:,3])::Ptr{Float64}, 
+								   N::Int32, 
+								   Int32(Nt)::Int32)::Cint
+
+	return Int.(perm) .+ 1
+end
+
+
+"""
+	bs_cwires_reduce(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+Reduce the field of `wires` at `nodes` in the C kernel without storing it (see 
+`bfield_reduce`): tiles of `tile` nodes are evaluated on `Nt` OpenMP threads.
+"""
+function bs_cwires_reduce(nodes::AbstractArray{Float32}, wires::AbstractArray{Wire{Float32}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(wires))
+	csources = convertCWires(wires)
+	# Weights and normals stay in double, like the sums they go into
+	w = isnothing(weights) ? C_NULL : Vector{Float64}(weights)
+	n = isnothing(normals) ? (C_NULL, C_NULL, C_NULL) : Tuple(Vector{Float64}(normals[:,k]) for k in 1:3)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	out = Ref{CReduction}()
+
+	status = @ccall wires_sp.bfield_wires_reduce(out::Ref{CReduction}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   w::Ptr{Float64},
+								   n[1]::Ptr{Float64},
+								   n[2]::Ptr{Float64},
+								   n[3]::Ptr{Float64},
+								   csources::Ptr{CWire32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   convert(Float32, mu_r)::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   Int32(tile)::Int32,
+								   Int32(Nt)::Int32)::Cint
+	kernelstatus(status, "bfield_wires_reduce")
+
+	return out[]
+end
+
+
+"""
+	bs_cwires_reduce(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+Reduce the field of `wires` at `nodes` in the C kernel without storing it (see 
+`bfield_reduce`): tiles of `tile` nodes are evaluated on `Nt` OpenMP threads.
+"""
+function bs_cwires_reduce(nodes::AbstractArray{Float64}, wires::AbstractArray{Wire{Float64}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(wires))
+	csources = convertCWires(wires)
+	w = isnothing(weights) ? C_NULL : Vector{Float64}(weights)
+	n = isnothing(normals) ? (C_NULL, C_NULL, C_NULL) : Tuple(Vector{Float64}(normals[:,k]) for k in 1:3)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	out = Ref{CReduction}()
+
+	status = @ccall wires_dp.bfield_wires_reduce(out::Ref{CReduction}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   w::Ptr{Float64},
+								   n[1]::Ptr{Float64},
+								   n[2]::Ptr{Float64},
+								   n[3]::Ptr{Float64},
+								   csources::Ptr{CWire64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   convert(Float64, mu_r)::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   Int32(tile)::Int32,
+								   Int32(Nt)::Int32)::Cint
+	kernelstatus(status, "bfield_wires_reduce")
+
+	return out[]
+end
+
+
+"""
+	bs_crings_reduce(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+Reduce the field of `rings` at `nodes` in the C kernel without storing it (see 
+`bfield_reduce`): tiles of `tile` nodes are evaluated on `Nt` OpenMP threads.
+"""
+function bs_crings_reduce(nodes::AbstractArray{Float32}, rings::AbstractArray{CircularRing{Float32}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	csources = convertCRings(rings)
+	# Weights and normals stay in double, like the sums they go into
+	w = isnothing(weights) ? C_NULL : Vector{Float64}(weights)
+	n = isnothing(normals) ? (C_NULL, C_NULL, C_NULL) : Tuple(Vector{Float64}(normals[:,k]) for k in 1:3)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	out = Ref{CReduction}()
+
+	status = @ccall rings_sp.bfield_rings_reduce(out::Ref{CReduction}, 
+								   (@view nodes[:,1])::Ptr{Float32},
+								   (@view nodes[:,2])::Ptr{Float32},
+								   (@view nodes[:,3])::Ptr{Float32}, 
+								   w::Ptr{Float64},
+								   n[1]::Ptr{Float64},
+								   n[2]::Ptr{Float64},
+								   n[3]::Ptr{Float64},
+								   csources::Ptr{CRing32},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   convert(Float32, mu_r)::Float32, 
+								   check::Int32,
+								   policy::Int32,
+								   Int32(tile)::Int32,
+								   Int32(Nt)::Int32)::Cint
+	kernelstatus(status, "bfield_rings_reduce")
+
+	return out[]
+end
+
+
+"""
+	bs_crings_reduce(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+Reduce the field of `rings` at `nodes` in the C kernel without storing it (see 
+`bfield_reduce`): tiles of `tile` nodes are evaluated on `Nt` OpenMP threads.
+"""
+function bs_crings_reduce(nodes::AbstractArray{Float64}, rings::AbstractArray{CircularRing{Float64}};
+					weights=nothing, normals=nothing, mu_r=1.0, tile=4096, Nt=Threads.nthreads())
+
+	kernelguard()
+
+	Nn = convert(Int32, size(nodes)[1])
+	Ns = convert(Int32, length(rings))
+	csources = convertCRings(rings)
+	w = isnothing(weights) ? C_NULL : Vector{Float64}(weights)
+	n = isnothing(normals) ? (C_NULL, C_NULL, C_NULL) : Tuple(Vector{Float64}(normals[:,k]) for k in 1:3)
+	check = check_inside ? Int32(1) : Int32(0)
+	policy = singularpolicy()
+	out = Ref{CReduction}()
+
+	status = @ccall rings_dp.bfield_rings_reduce(out::Ref{CReduction}, 
+								   (@view nodes[:,1])::Ptr{Float64},
+								   (@view nodes[:,2])::Ptr{Float64},
+								   (@view nodes[:,3])::Ptr{Float64}, 
+								   w::Ptr{Float64},
+								   n[1]::Ptr{Float64},
+								   n[2]::Ptr{Float64},
+								   n[3]::Ptr{Float64},
+								   csources::Ptr{CRing64},
+								   Nn::Int32, 
+								   Ns::Int32, 
+								   convert(Float64, mu_r)::Float64, 
+								   check::Int32,
+								   policy::Int32,
+								   Int32(tile)::Int32,
+								   Int32(Nt)::Int32)::Cint
+	kernelstatus(status, "bfield_rings_reduce")
+
+	return out[]
+end
@@ -0,0 +1,176 @@
+/*  Uniform-grid cell list over node points for the Wired.jl C kernel
+
+    Notes
+    - Define REAL (float or double) before including this file
+    - Used to find the few node/source pairs that lie inside a conductor, so the
+      current density correction can be applied to those pairs only
+*/
+
+#ifndef WIRED_CELLLIST_H
+#define WIRED_CELLLIST_H
+
+#include <math.h>
+#include <stdlib.h>
+
+/*
+    CellList
+
+Nodes binned into cubic cells of side h, stored in CSR form: the nodes in
+cell c are idx[start[c]] ... idx[start[c+1]-1].
+*/
+typedef struct {
+    double lo[3];       // lower corner of the grid
+    double h;           // cell side length
+    int n[3];           // number of cells along each axis
+    int* start;         // cell offsets into idx (length n[0]*n[1]*n[2] + 1)
+    int* idx;           // node indices, grouped by cell
+} CellList;
+
+/*
+    PairList
+
+Node indices and current density correction factors for one source after
+another, in CSR form: the entries for source i are ptr[i] ... ptr[i+1]-1.
+*/
+typedef struct {
+    int* ptr;
+    int* idx;
+    REAL* jc;
+    int n;
+    int cap;
+} PairList;
+
+
+static inline int cell_coord(const CellList* cl, double v, int axis) {
+    int c = (int)floor((v - cl->lo[axis]) / cl->h);
+    if (c < 0) c = 0;
+    if (c >= cl->n[axis]) c = cl->n[axis] - 1;
+    return c;
+}
+
+static inline void celllist_free(CellList* cl) {
+    free(cl->start);
+    free(cl->idx);
+    cl->start = NULL;
+    cl->idx = NULL;
+}
+
+/*
+    celllist_build(cl, x, y, z, Nn)
+
+Bin Nn nodes into a uniform grid sized for ~2 nodes per occupied cell.
+Degenerate directions (e.g. all nodes on a plane or line) get a single cell.
+Returns 0 on success.
+*/
+static int celllist_build(CellList* cl, const REAL* x, const REAL* y, const REAL* z, int Nn) {
+    double hi[3];
+    const REAL* c[3] = {x, y, z};
+
+    for (int d=0; d<3; d++) {
+        cl->lo[d] = (Nn > 0) ? c[d][0] : 0;
+        hi[d] = cl->lo[d];
+        for (int j=1; j<Nn; j++) {
+            if (c[d][j] < cl->lo[d]) cl->lo[d] = c[d][j];
+            if (c[d][j] > hi[d]) hi[d] = c[d][j];
+        }
+    }
+
+    // Cell size from the volume (or area, or length) spanned by the nodes
+    double extmax = 0;
+    for (int d=0; d<3; d++) extmax = fmax(extmax, hi[d] - cl->lo[d]);
+    double content = 1;
+    int dims = 0;
+    for (int d=0; d<3; d++) {
+        if (hi[d] - cl->lo[d] > 1e-9*extmax) {
+            content *= hi[d] - cl->lo[d];
+            dims++;
+        }
+    }
+    cl->h = (dims > 0) ? pow(2.0*content/fmax(Nn, 1), 1.0/dims) : 1.0;
+
+    // Very elongated node sets can still ask for too many cells; coarsen
+    double ncells;
+    while (1) {
+        ncells = 1;
+        for (int d=0; d<3; d++) {
+            cl->n[d] = (int)fmin(floor((hi[d] - cl->lo[d]) / cl->h) + 1, 1 << 20);
+            ncells *= cl->n[d];
+        }
+        if (ncells <= 4.0*Nn + 64) break;
+        cl->h *= 1.5;
+    }
+
+    int* cell = malloc((size_t)Nn * sizeof(int));
+    cl->start = calloc((size_t)ncells + 1, sizeof(int));
+    cl->idx = malloc((size_t)Nn * sizeof(int));
+    if (!(cell && cl->start && cl->idx)) {
+        free(cell);
+        celllist_free(cl);
+        return 1;
+    }
+
+    // Counting sort of nodes by cell
+    for (int j=0; j<Nn; j++) {
+        int i0 = cell_coord(cl, x[j], 0);
+        int i1 = cell_coord(cl, y[j], 1);
+        int i2 = cell_coord(cl, z[j], 2);
+        cell[j] = (i2*cl->n[1] + i1)*cl->n[0] + i0;
+        cl->start[cell[j] + 1]++;
+    }
+    for (long k=0; k<(long)ncells; k++) cl->start[k+1] += cl->start[k];
+    for (int j=0; j<Nn; j++) cl->idx[cl->start[cell[j]]++] = j;
+    for (long k=(long)ncells; k>0; k--) cl->start[k] = cl->start[k-1];
+    cl->start[0] = 0;
+
+    free(cell);
+    return 0;
+}
+
+
+// Range of cells [c0, c1] overlapped by the box [lo, hi]; returns 0 if empty
+static inline int celllist_range(const CellList* cl, const double* lo, const double* hi,
+                                 int* c0, int* c1) {
+    for (int d=0; d<3; d++) {
+        double top = cl->lo[d] + cl->n[d]*cl->h;
+        if (hi[d] < cl->lo[d] || lo[d] > top) return 0;
+        c0[d] = cell_coord(cl, lo[d], d);
+        c1[d] = cell_coord(cl, hi[d], d);
+    }
+    return 1;
+}
+
+static inline int pairlist_init(PairList* p, int Ns) {
+    p->ptr = calloc(Ns + 1, sizeof(int));
+    p->cap = 64;
+    p->n = 0;
+    p->idx = malloc(p->cap * sizeof(int));
+    p->jc = malloc(p->cap * sizeof(REAL));
+    return !(p->ptr && p->idx && p->jc);
+}
+
+// Returns nonzero, leaving the list as it was, if it cannot grow
+static inline int pairlist_push(PairList* p, int j, REAL jc) {
+    if (p->n == p->cap) {
+        int* idx = realloc(p->idx, 2 * (size_t)p->cap * sizeof(int));
+        if (!idx) return 1;
+        p->idx = idx;
+        REAL* jcs = realloc(p->jc, 2 * (size_t)p->cap * sizeof(REAL));
+        if (!jcs) return 1;
+        p->jc = jcs;
+        p->cap *= 2;
+    }
+    p->idx[p->n] = j;
+    p->jc[p->n] = jc;
+    p->n++;
+    return 0;
+}
+
+// Safe to call again, or on a list that failed to initialize
+static inline void pairlist_free(PairList* p) {
+    free(p->ptr);
+    free(p->idx);
+    free(p->jc);
+    *p = (PairList) {0};
+}
+
+#endif
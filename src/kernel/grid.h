@@ -0,0 +1,38 @@
+/*  Structured-grid field targets for the Wired.jl C kernel
+
+    Notes
+    - Define REAL (float or double) before including this file
+    - Grid nodes are generated inside the kernels, so no node arrays are
+      passed in; outputs are stored with the first grid index varying fastest
+      (the column-major order of a Julia array of size n[0] x n[1] x n[2])
+*/
+
+#ifndef WIRED_GRID_H
+#define WIRED_GRID_H
+
+// Match the Grid definition in Julia: node (i,j,k) is o + i*e[0] + j*e[1] + k*e[2]
+typedef struct {
+    REAL o[3];          // first node
+    REAL e[3][3];       // step vector along each grid axis
+    int n[3];           // number of nodes along each grid axis
+} Grid;
+
+// Match the CylindricalGrid definition in Julia: node (i,j,k) is at radius
+//  r0 + i*dr, azimuth phi0 + j*dphi and height z0 + k*dz
+typedef struct {
+    REAL r0, dr;
+    REAL phi0, dphi;
+    REAL z0, dz;
+    int n[3];           // number of nodes in r, phi, z
+} CylindricalGrid;
+
+// Number of grid rows (nodes that differ only in the first index) per block;
+//  a block of output stays in cache while every source is added to it
+#define GRID_BLOCK_NODES 4096
+
+static inline int grid_rows_per_block(int n0) {
+    int rows = GRID_BLOCK_NODES / (n0 > 0 ? n0 : 1);
+    return (rows > 0) ? rows : 1;
+}
+
+#endif
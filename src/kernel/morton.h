@@ -0,0 +1,147 @@
+/*  Morton (Z-order) sorting of points for the Wired.jl C kernel
+
+    Notes
+    - Define REAL (float or double) before including this file
+    - Points are quantized to 21 bits per axis over their bounding cube, and
+      the bits are interleaved into a 63-bit code (x in bit 0, y in bit 1,
+      z in bit 2), so points that are close in the sorted order are close
+      in space
+    - The codes are sorted by a parallel LSD radix sort (11 bits per pass,
+      six passes): each thread counts the digits of its own block of points,
+      and the counts are prefix-summed digit by digit, thread by thread, so
+      every pass is stable and the result does not depend on the number of
+      threads
+*/
+
+#ifndef WIRED_MORTON_H
+#define WIRED_MORTON_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#define MORTON_BITS 21
+#define MORTON_DIGIT 11
+#define MORTON_RADIX (1 << MORTON_DIGIT)
+
+// Spread the low 21 bits of v so that there are two zero bits between each
+static inline uint64_t morton_spread(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8)  & 0x100f00f00f00f00fULL;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2)  & 0x1249249249249249ULL;
+    return v;
+}
+
+// Quantize a coordinate to [0, 2^21 - 1]
+static inline uint64_t morton_quantize(double v, double lo, double scale) {
+    double q = (v - lo)*scale;
+    if (!(q > 0)) return 0;
+    if (q >= (double)((1 << MORTON_BITS) - 1)) return (1 << MORTON_BITS) - 1;
+    return (uint64_t)q;
+}
+
+/*
+    morton_order(perm, x, y, z, N, Nt)
+
+Write the permutation that sorts N points (x,y,z) along a Morton curve to perm
+(0-based: perm[k] is the index of the k-th point in the sorted order), using Nt
+OpenMP threads. Returns 0 on success.
+*/
+static int morton_order(int* perm, const REAL* x, const REAL* y, const REAL* z, int N, int Nt) {
+    if (N <= 0) return 0;
+    if (Nt < 1) Nt = 1;
+
+    uint64_t* key = malloc(2*(size_t)N*sizeof(uint64_t));
+    int* idx = malloc((size_t)N*sizeof(int));
+    size_t* count = malloc((size_t)Nt*MORTON_RADIX*sizeof(size_t));
+    if (!key || !idx || !count) {
+        free(key); free(idx); free(count);
+        return 1;
+    }
+
+    // Bounding cube of the points
+    double lo[3] = {x[0], y[0], z[0]};
+    double hi[3] = {x[0], y[0], z[0]};
+    #pragma omp parallel for num_threads(Nt) reduction(min:lo[:3]) reduction(max:hi[:3])
+    for (int j=0; j<N; j++) {
+        lo[0] = fmin(lo[0], x[j]); hi[0] = fmax(hi[0], x[j]);
+        lo[1] = fmin(lo[1], y[j]); hi[1] = fmax(hi[1], y[j]);
+        lo[2] = fmin(lo[2], z[j]); hi[2] = fmax(hi[2], z[j]);
+    }
+    double extent = fmax(hi[0] - lo[0], fmax(hi[1] - lo[1], hi[2] - lo[2]));
+    double scale = (extent > 0) ? ((1 << MORTON_BITS) - 1)/extent : 0;
+
+    uint64_t* src = key;
+    uint64_t* dst = key + N;
+    int* psrc = perm;
+    int* pdst = idx;
+
+    #pragma omp parallel for num_threads(Nt)
+    for (int j=0; j<N; j++) {
+        src[j] = morton_spread(morton_quantize(x[j], lo[0], scale))
+                | morton_spread(morton_quantize(y[j], lo[1], scale)) << 1
+                | morton_spread(morton_quantize(z[j], lo[2], scale)) << 2;
+        psrc[j] = j;
+    }
+
+    for (int shift=0; shift<3*MORTON_BITS; shift+=MORTON_DIGIT) {
+        int skip = 0;
+
+        #pragma omp parallel num_threads(Nt)
+        {
+            int t = omp_get_thread_num();
+            int nt = omp_get_num_threads();
+            int j0 = (int)((long)N*t/nt);
+            int j1 = (int)((long)N*(t+1)/nt);
+            size_t* c = count + (size_t)t*MORTON_RADIX;
+
+            memset(c, 0, MORTON_RADIX*sizeof(size_t));
+            for (int j=j0; j<j1; j++) {
+                c[(src[j] >> shift) & (MORTON_RADIX - 1)]++;
+            }
+            #pragma omp barrier
+
+            // Offsets: digit by digit, and thread by thread within a digit
+            #pragma omp single
+            {
+                size_t offset = 0;
+                for (int d=0; d<MORTON_RADIX; d++) {
+                    size_t total = 0;
+                    for (int s=0; s<nt; s++) {
+                        size_t n = count[(size_t)s*MORTON_RADIX + d];
+                        count[(size_t)s*MORTON_RADIX + d] = offset;
+                        offset += n;
+                        total += n;
+                    }
+                    // Every code has this digit: the pass would not move anything
+                    if (total == (size_t)N) skip = 1;
+                }
+            }
+
+            if (!skip) {
+                for (int j=j0; j<j1; j++) {
+                    size_t k = c[(src[j] >> shift) & (MORTON_RADIX - 1)]++;
+                    dst[k] = src[j];
+                    pdst[k] = psrc[j];
+                }
+            }
+        }
+
+        if (!skip) {
+            uint64_t* tk = src; src = dst; dst = tk;
+            int* tp = psrc; psrc = pdst; pdst = tp;
+        }
+    }
+
+    if (psrc != perm) memcpy(perm, psrc, (size_t)N*sizeof(int));
+
+    free(key); free(idx); free(count);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,337 @@
+/*  Distributed (MPI) driver for Wired.jl - Single-Precision
+
+    Notes
+    - Built as an executable with `make mpi`, linked against the native kernels
+    - Run as `mpirun -np P bfield_mpi_sp job.bin out.bin [options]`
+    - The sources are read by rank 0 and broadcast; each rank reads only its
+      own node slices from the job file, runs the natively-threaded kernel on
+      them, and writes its slices of the output with MPI-IO
+    - Job file (written by `Wired.writejob`): a 64-byte header, the node
+      coordinates x[Nn], y[Nn], z[Nn], then Ns source structs
+    - Output file: Bx[Nn], By[Nn], Bz[Nn] (an Nn x 3 column-major matrix)
+
+    Options
+    --threads N     OpenMP threads per rank (default: OMP_NUM_THREADS)
+    --balance       hand out chunks of nodes on demand instead of one slice
+                    per rank, for sources whose cost varies between nodes
+    --chunk N       nodes per chunk with --balance (default: Nn/(16 P))
+    --verbose       print the nodes and kernel time of each rank
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "parallel.h"
+
+// Match the source definitions in the kernels (and Julia)
+typedef struct {
+    float a0[3];
+    float a1[3];
+    float I;
+    float R;
+} Wire;
+
+typedef struct {
+    float H;
+    float R;
+    float r;
+    float I;
+} Ring;
+
+typedef struct {
+    float c[3];
+    float n[3];
+    float R;
+    float r;
+    float I;
+} OrientedRing;
+
+typedef struct {
+    float H;
+    float R;
+    float w;
+    float h;
+    float I;
+} RectangularRing;
+
+typedef struct {
+    float v[4][3];
+    float J[3];
+} Tet;
+
+// Source kinds, as written by Julia
+enum {KIND_WIRES=1, KIND_RINGS=2, KIND_ORIENTED_RINGS=3, KIND_RECT_RINGS=4, KIND_TETS=5};
+
+// Match the job file header written by Julia
+typedef struct {
+    char magic[8];      // "WIREDMPI"
+    long kind;          // source kind
+    long real;          // bytes per floating-point value
+    long Nn;            // number of nodes
+    long Ns;            // number of sources
+    double mu_r;       // relative permeability
+    double tol;        // quadrature tolerance (rectangular rings)
+    long flags;         // bit 0: current density correction inside conductors,
+                        //  bits 1-2: singularity policy (see singular.h)
+} JobHeader;
+
+int bfield_wires_parallel(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const Wire* wires, int Nn, int Nw, float mu_r, int check_inside,
+                int policy, int* nsing, const ParallelOptions* opts, const int* cpus, ThreadStats* stats);
+
+int bfield_rings_parallel(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const Ring* rings, int Nn, int Nr, float mu_r, int check_inside,
+                int policy, int* nsing, const ParallelOptions* opts, const int* cpus, ThreadStats* stats);
+
+int bfield_oriented_rings_parallel(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const OrientedRing* rings, int Nn, int Nr, float mu_r, int check_inside,
+                int policy, int* nsing, const ParallelOptions* opts, const int* cpus, ThreadStats* stats);
+
+int bfield_rect_rings_parallel(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const RectangularRing* rings, int Nn, int Nr, float mu_r, float tol,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats);
+
+int bfield_tets_parallel(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const Tet* tets, int Nn, int Ne, float mu_r,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats);
+
+
+// Size in bytes of one source of each kind; 0 if the kind is unknown
+static size_t source_size(long kind) {
+    switch (kind) {
+        case KIND_WIRES: return sizeof(Wire);
+        case KIND_RINGS: return sizeof(Ring);
+        case KIND_ORIENTED_RINGS: return sizeof(OrientedRing);
+        case KIND_RECT_RINGS: return sizeof(RectangularRing);
+        case KIND_TETS: return sizeof(Tet);
+    }
+    return 0;
+}
+
+
+/*
+    run_kernel(B, x, n, job, sources, opts, stats)
+
+Overwrite B (3n values: Bx, By, Bz) with the field of every source at the n
+nodes x (3n values: x, y, z), using the natively-threaded kernel.
+*/
+static int run_kernel(float* B, const float* x, int n, const JobHeader* job,
+                      const void* sources, const ParallelOptions* opts, ThreadStats* stats)
+{
+    float* Bx = B;
+    float* By = B + n;
+    float* Bz = B + 2*n;
+    const float* xn = x;
+    const float* yn = x + n;
+    const float* zn = x + 2*n;
+    int Ns = (int)job->Ns;
+    int check = (int)(job->flags & 1);
+    int policy = (int)(job->flags >> 1) & 3;
+
+    switch (job->kind) {
+        case KIND_WIRES:
+            return bfield_wires_parallel(Bx, By, Bz, xn, yn, zn, sources, n, Ns,
+                                         job->mu_r, check, policy, NULL, opts, NULL, stats);
+        case KIND_RINGS:
+            return bfield_rings_parallel(Bx, By, Bz, xn, yn, zn, sources, n, Ns,
+                                         job->mu_r, check, policy, NULL, opts, NULL, stats);
+        case KIND_ORIENTED_RINGS:
+            return bfield_oriented_rings_parallel(Bx, By, Bz, xn, yn, zn, sources, n, Ns,
+                                                  job->mu_r, check, policy, NULL, opts, NULL, stats);
+        case KIND_RECT_RINGS:
+            return bfield_rect_rings_parallel(Bx, By, Bz, xn, yn, zn, sources, n, Ns,
+                                              job->mu_r, job->tol, opts, NULL, stats);
+        case KIND_TETS:
+            return bfield_tets_parallel(Bx, By, Bz, xn, yn, zn, sources, n, Ns,
+                                        job->mu_r, opts, NULL, stats);
+    }
+    return 1;
+}
+
+
+/*
+    run_chunk(in, out, job, sources, n0, n, buf, opts, stats)
+
+Read nodes n0 ... n0+n-1 from the job file, calculate their field and write it
+to the output file. `buf` holds at least 6n floats.
+*/
+static int run_chunk(MPI_File in, MPI_File out, const JobHeader* job, const void* sources,
+                     long n0, int n, float* buf, const ParallelOptions* opts, ThreadStats* stats)
+{
+    float* x = buf;
+    float* B = buf + 3*(size_t)n;
+    int status = 0;
+
+    for (int d=0; d<3; d++) {
+        MPI_Offset offset = sizeof(JobHeader) + (d*job->Nn + n0)*sizeof(float);
+        status |= MPI_File_read_at(in, offset, x + d*(size_t)n, n, MPI_FLOAT, MPI_STATUS_IGNORE);
+    }
+
+    status |= run_kernel(B, x, n, job, sources, opts, stats);
+
+    for (int d=0; d<3; d++) {
+        MPI_Offset offset = (d*job->Nn + n0)*sizeof(float);
+        status |= MPI_File_write_at(out, offset, B + d*(size_t)n, n, MPI_FLOAT, MPI_STATUS_IGNORE);
+    }
+
+    return status;
+}
+
+
+int main(int argc, char** argv) {
+
+    MPI_Init(&argc, &argv);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc < 3) {
+        if (rank == 0) printf("usage: bfield_mpi_sp job.bin out.bin [--threads N] [--balance] [--chunk N] [--verbose]\n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    int Nt = omp_get_max_threads();
+    int balance = 0;
+    int verbose = 0;
+    long chunk = 0;
+    for (int k=3; k<argc; k++) {
+        if (!strcmp(argv[k], "--threads") && k+1 < argc) Nt = atoi(argv[++k]);
+        else if (!strcmp(argv[k], "--chunk") && k+1 < argc) chunk = atol(argv[++k]);
+        else if (!strcmp(argv[k], "--balance")) balance = 1;
+        else if (!strcmp(argv[k], "--verbose")) verbose = 1;
+    }
+    if (Nt < 1) Nt = 1;
+
+    MPI_File in, out;
+    if (MPI_File_open(MPI_COMM_WORLD, argv[1], MPI_MODE_RDONLY, MPI_INFO_NULL, &in)) {
+        if (rank == 0) printf("error! cannot open %s\n", argv[1]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Rank 0 reads the header and the sources, and broadcasts them
+    JobHeader job;
+    int valid = 1;
+    if (rank == 0) {
+        MPI_File_read_at(in, 0, &job, sizeof(JobHeader), MPI_BYTE, MPI_STATUS_IGNORE);
+        valid = !memcmp(job.magic, "WIREDMPI", 8) && job.real == sizeof(float) &&
+                source_size(job.kind) > 0 && job.Nn >= 0 && job.Ns >= 0;
+    }
+    MPI_Bcast(&valid, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!valid) {
+        if (rank == 0) printf("error! %s is not a single-precision job file\n", argv[1]);
+        MPI_File_close(&in);
+        MPI_Finalize();
+        return 1;
+    }
+    MPI_Bcast(&job, sizeof(JobHeader), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    size_t bytes = job.Ns * source_size(job.kind);
+    void* sources = malloc(bytes > 0 ? bytes : 1);
+    if (!sources) {
+        printf("error! rank %d cannot allocate the sources\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (rank == 0) {
+        MPI_Offset offset = sizeof(JobHeader) + 3*job.Nn*sizeof(float);
+        MPI_File_read_at(in, offset, sources, (int)bytes, MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    MPI_Bcast(sources, (int)bytes, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    if (MPI_File_open(MPI_COMM_WORLD, argv[2], MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &out)) {
+        if (rank == 0) printf("error! cannot open %s\n", argv[2]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_File_set_size(out, 3*job.Nn*sizeof(float));
+
+    // Pinning is left off: several ranks may share one machine
+    ParallelOptions opts = {.Nt=Nt, .firsttouch=0, .pin=0, .socketaware=0};
+    ThreadStats* stats = malloc(Nt * sizeof(ThreadStats));
+    if (!stats) {
+        printf("error! rank %d cannot allocate its thread statistics\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int status = 0;
+    long mine = 0;
+    double start = MPI_Wtime();
+
+    if (!balance) {
+        // One contiguous slice per rank
+        long n0 = (job.Nn * rank) / size;
+        long n1 = (job.Nn * (rank+1)) / size;
+        float* buf = malloc(6 * (size_t)(n1 - n0 + 1) * sizeof(float));
+        if (!buf) status |= 1;
+        else if (n1 > n0) status |= run_chunk(in, out, &job, sources, n0, (int)(n1 - n0), buf, &opts, stats);
+        mine = n1 - n0;
+        free(buf);
+    }
+    else {
+        // Chunks are claimed one at a time from a shared counter held by rank 0,
+        //  so ranks that draw cheap nodes simply take more chunks
+        if (chunk <= 0) chunk = job.Nn / (16*size);
+        if (chunk <= 0) chunk = 1;
+        long nchunks = (job.Nn + chunk - 1) / chunk;
+        long counter = 0;
+        MPI_Win win;
+        MPI_Win_create(&counter, (rank == 0) ? sizeof(long) : 0, sizeof(long),
+                       MPI_INFO_NULL, MPI_COMM_WORLD, &win);
+
+        // A rank without a buffer claims no chunks (the others still cover every 
+        //  node), but the run is reported as failed
+        float* buf = malloc(6 * (size_t)chunk * sizeof(float));
+        if (!buf) status |= 1;
+        long one = 1;
+        while (buf) {
+            long k;
+            MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, win);
+            MPI_Fetch_and_op(&one, &k, MPI_LONG, 0, 0, MPI_SUM, win);
+            MPI_Win_unlock(0, win);
+            if (k >= nchunks) break;
+
+            long n0 = k*chunk;
+            long n = (n0 + chunk <= job.Nn) ? chunk : job.Nn - n0;
+            status |= run_chunk(in, out, &job, sources, n0, (int)n, buf, &opts, stats);
+            mine += n;
+        }
+        free(buf);
+        MPI_Win_free(&win);
+    }
+
+    double elapsed = MPI_Wtime() - start;
+
+    if (verbose) {
+        double* times = malloc(size * sizeof(double));
+        long* counts = malloc(size * sizeof(long));
+        // Only rank 0 receives, so it decides whether the report can be gathered
+        int ok = (times && counts);
+        MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (ok) {
+            MPI_Gather(&elapsed, 1, MPI_DOUBLE, times, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            MPI_Gather(&mine, 1, MPI_LONG, counts, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+            if (rank == 0) {
+                for (int r=0; r<size; r++) printf("rank %d: %ld nodes, %.6f s\n", r, counts[r], times[r]);
+            }
+        }
+        else if (rank == 0) printf("error! cannot allocate the timing report\n");
+        free(times);
+        free(counts);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_BOR, MPI_COMM_WORLD);
+
+    free(stats);
+    free(sources);
+    MPI_File_close(&out);
+    MPI_File_close(&in);
+    MPI_Finalize();
+    return status ? 1 : 0;
+}
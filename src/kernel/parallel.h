@@ -0,0 +1,256 @@
+/*  Native threading helpers for the Wired.jl C kernel
+
+    Notes
+    - Shared by the wire and ring kernels (all precisions)
+    - Nodes are split into contiguous partitions, one per OpenMP thread
+    - Each thread may be pinned to a core, and partitions may be ordered by
+      the NUMA node of the owning thread so that threads on the same socket
+      own neighbouring blocks of the node and output arrays
+    - Thread 0 of a kernel call is the caller's (Julia) thread, and the other
+      threads stay in the OpenMP pool, so every thread restores the affinity
+      it had before it was pinned when the call ends
+    - Define REAL (float or double) before including this file for the node
+      partition helpers (field_parallel); the types and run_partitions do not
+      need it
+*/
+
+#ifndef WIRED_PARALLEL_H
+#define WIRED_PARALLEL_H
+
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// Match the ParallelOptions definition in Julia
+typedef struct {
+    int Nt;             // number of threads
+    int firsttouch;     // copy node/output partitions into thread-local memory
+    int pin;            // pin thread t to core cpus[t] (or core t if cpus is NULL)
+    int socketaware;    // order node partitions by the NUMA node of each thread
+} ParallelOptions;
+
+// Match the ThreadStats definition in Julia
+typedef struct {
+    int cpu;            // core the thread was running on
+    int node;           // NUMA node of that core
+    int n0;             // first node index (0-based) owned by the thread
+    int n1;             // one past the last node index owned by the thread
+    double elapsed;     // wall-clock time spent in the kernel [s]
+} ThreadStats;
+
+
+// Affinity of a thread, saved while it is pinned
+#ifdef __linux__
+typedef cpu_set_t AffinityMask;
+#else
+typedef int AffinityMask;
+#endif
+
+// Save the affinity of the calling thread; returns 0 on success
+static inline int save_affinity(AffinityMask* mask) {
+#ifdef __linux__
+    return sched_getaffinity(0, sizeof(*mask), mask);
+#else
+    (void)mask;
+    return -1;
+#endif
+}
+
+// Restore an affinity saved by save_affinity
+static inline void restore_affinity(const AffinityMask* mask) {
+#ifdef __linux__
+    sched_setaffinity(0, sizeof(*mask), mask);
+#else
+    (void)mask;
+#endif
+}
+
+// Pin the calling thread to a single core; returns 0 on success
+static inline int pin_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+// Core and NUMA node the calling thread is currently running on
+static inline void current_cpu_node(int* cpu, int* node) {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned c = 0, n = 0;
+    if (syscall(SYS_getcpu, &c, &n, NULL) == 0) {
+        *cpu = (int)c;
+        *node = (int)n;
+        return;
+    }
+#endif
+    *cpu = -1;
+    *node = 0;
+}
+
+/*
+    partition_nodes(stats, Nt, Nn, socketaware)
+
+Split Nn nodes into Nt contiguous, near-equal partitions. With `socketaware`,
+threads are ordered by (NUMA node, thread number) before the partitions are
+handed out, so each socket owns one contiguous block of the node arrays.
+*/
+static inline void partition_nodes(ThreadStats* stats, int Nt, int Nn, int socketaware) {
+    int order[Nt];
+    for (int t=0; t<Nt; t++) order[t] = t;
+
+    // Insertion sort is plenty for a few hundred threads
+    if (socketaware) {
+        for (int t=1; t<Nt; t++) {
+            int k = order[t];
+            int s = t - 1;
+            while (s >= 0 && stats[order[s]].node > stats[k].node) {
+                order[s+1] = order[s];
+                s--;
+            }
+            order[s+1] = k;
+        }
+    }
+
+    for (int p=0; p<Nt; p++) {
+        stats[order[p]].n0 = (int)(((long)Nn * p) / Nt);
+        stats[order[p]].n1 = (int)(((long)Nn * (p+1)) / Nt);
+    }
+}
+
+
+// Work of one thread on its partition n0 ... n1-1 of a kernel call
+typedef int (*PartitionWork)(int n0, int n1, const ParallelOptions* opts, const void* ctx);
+
+/*
+    run_partitions(work, ctx, N, opts, cpus, stats)
+
+Split N items (nodes, grid rows, ...) into opts->Nt partitions (see 
+`partition_nodes`) and run `work` on each, one OpenMP thread per partition, with 
+the threads pinned as set in opts. Per-thread placement, partitions and timing are 
+reported in `stats`, which must hold at least opts->Nt entries. Returns the OR of 
+the statuses returned by `work`.
+*/
+static int run_partitions(PartitionWork work, const void* ctx, int N, 
+                          const ParallelOptions* opts, const int* cpus, ThreadStats* stats) {
+    int status = 0;
+
+    #pragma omp parallel num_threads(opts->Nt) reduction(|:status)
+    {
+        int t = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        AffinityMask mask;
+        int pinned = opts->pin && save_affinity(&mask) == 0 && pin_thread(cpus ? cpus[t] : t) == 0;
+        current_cpu_node(&stats[t].cpu, &stats[t].node);
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            partition_nodes(stats, nt, N, opts->socketaware);
+            for (int s=nt; s<opts->Nt; s++) {
+                stats[s] = (ThreadStats) {.cpu=-1, .node=-1, .n0=0, .n1=0, .elapsed=0};
+            }
+        }
+
+        double start = omp_get_wtime();
+        status |= work(stats[t].n0, stats[t].n1, opts, ctx);
+        stats[t].elapsed = omp_get_wtime() - start;
+
+        if (pinned) restore_affinity(&mask);
+    }
+
+    return status;
+}
+
+#endif
+
+
+#if defined(REAL) && !defined(WIRED_PARALLEL_FIELD_H)
+#define WIRED_PARALLEL_FIELD_H
+
+#include <stdlib.h>
+
+// Field of n nodes from a kernel, overwriting (Bx, By, Bz) and adding the 
+//  singular pairs of each node to count (if not NULL)
+typedef int (*TileField)(REAL* Bx, REAL* By, REAL* Bz, const REAL* x, const REAL* y, 
+                         const REAL* z, int n, int* count, const void* ctx);
+
+// Arrays and kernel of a natively parallel field evaluation
+typedef struct {
+    REAL* Bx;
+    REAL* By;
+    REAL* Bz;
+    const REAL* x;
+    const REAL* y;
+    const REAL* z;
+    int* nsing;
+    TileField field;
+    const void* ctx;
+} FieldWork;
+
+// Field of the nodes n0 ... n1-1 of a FieldWork (see field_parallel)
+static int field_partition(int n0, int n1, const ParallelOptions* opts, const void* ctx) {
+    const FieldWork* c = ctx;
+    int n = n1 - n0;
+    int* nsing = c->nsing ? c->nsing + n0 : NULL;
+    if (n <= 0) return 0;
+
+    if (!opts->firsttouch) {
+        return c->field(c->Bx + n0, c->By + n0, c->Bz + n0, c->x + n0, c->y + n0, c->z + n0, 
+                        n, nsing, c->ctx);
+    }
+
+    // Thread-local copies are first touched (and so placed) here
+    REAL* local = malloc(6 * (size_t)n * sizeof(REAL));
+    if (!local) return 1;
+    REAL* xl = local;
+    REAL* yl = local + n;
+    REAL* zl = local + 2*n;
+    REAL* Bxl = local + 3*n;
+    REAL* Byl = local + 4*n;
+    REAL* Bzl = local + 5*n;
+    for (int j=0; j<n; j++) {
+        xl[j] = c->x[n0+j];
+        yl[j] = c->y[n0+j];
+        zl[j] = c->z[n0+j];
+    }
+    int status = c->field(Bxl, Byl, Bzl, xl, yl, zl, n, nsing, c->ctx);
+    for (int j=0; j<n; j++) {
+        c->Bx[n0+j] = Bxl[j];
+        c->By[n0+j] = Byl[j];
+        c->Bz[n0+j] = Bzl[j];
+    }
+    free(local);
+
+    return status;
+}
+
+/*
+    field_parallel(Bx, By, Bz, x, y, z, Nn, nsing, field, ctx, opts, cpus, stats)
+
+Native (OpenMP) parallel evaluation of a kernel `field` at Nn nodes: the nodes are 
+partitioned across threads (see `run_partitions`) and each thread evaluates every 
+source for its own partition, so no cross-thread reduction is needed. The output 
+arrays are overwritten (not accumulated), which lets each thread first-touch its 
+own output partition. 
+
+With opts->firsttouch, each thread also copies its slice of the node coordinates 
+into memory it allocated itself, so that on multi-socket machines the coordinates, 
+scratch and output of a partition all live on the socket of the thread that uses 
+them. nsing (singular pairs per node) may be NULL.
+*/
+static int field_parallel(REAL* Bx, REAL* By, REAL* Bz, const REAL* x, const REAL* y, const REAL* z, 
+                          int Nn, int* nsing, TileField field, const void* ctx, 
+                          const ParallelOptions* opts, const int* cpus, ThreadStats* stats) {
+    FieldWork work = {Bx, By, Bz, x, y, z, nsing, field, ctx};
+    return run_partitions(field_partition, &work, Nn, opts, cpus, stats);
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*  Gauss-Legendre quadrature rules for the Wired.jl C kernel
+
+    Notes
+    - Rules of order 2, 4, 8 and 16 on [-1, 1]
+    - Only the positive abscissae are stored; the rules are symmetric
+*/
+
+#ifndef WIRED_QUADRATURE_H
+#define WIRED_QUADRATURE_H
+
+#define GL_NRULES 4
+
+static const int gl_order[GL_NRULES] = {2, 4, 8, 16};
+static const int gl_offset[GL_NRULES] = {0, 1, 3, 7};
+
+static const double gl_x[15] = {
+    0.57735026918962573,
+    0.33998104358485626, 0.86113631159405257,
+    0.18343464249564978, 0.52553240991632899, 0.79666647741362673, 0.96028985649753618,
+    0.095012509837637441, 0.28160355077925892, 0.45801677765722737, 0.61787624440264377, 
+    0.755404408355003, 0.86563120238783176, 0.9445750230732326, 0.98940093499164994
+};
+
+static const double gl_w[15] = {
+    1.0,
+    0.65214515486254643, 0.34785484513745357,
+    0.36268378337836166, 0.31370664587788688, 0.22238103445337443, 0.10122853629037706,
+    0.18945061045506864, 0.18260341504492364, 0.16915651939500265, 0.14959598881657671, 
+    0.12462897125553407, 0.095158511682492605, 0.062253523938647456, 0.027152459411754176
+};
+
+/*
+    gl_rule(q, x, w)
+
+Expand rule number q (order gl_order[q]) into full abscissae x and weights w on
+[-1, 1]. x and w must hold at least gl_order[q] entries.
+*/
+static inline void gl_rule(int q, double* x, double* w) {
+    int n = gl_order[q];
+    for (int k=0; k<n/2; k++) {
+        x[n/2 - 1 - k] = -gl_x[gl_offset[q] + k];
+        x[n/2 + k] = gl_x[gl_offset[q] + k];
+        w[n/2 - 1 - k] = gl_w[gl_offset[q] + k];
+        w[n/2 + k] = gl_w[gl_offset[q] + k];
+    }
+}
+
+#endif
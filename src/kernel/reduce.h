@@ -0,0 +1,143 @@
+/*  Streaming reductions of the field for the Wired.jl C kernel
+
+    Notes
+    - Define REAL (float or double) before including this file
+    - The nodes are evaluated in tiles of a few thousand, handed out to the
+      OpenMP threads as they become free; the field of a tile only lives in
+      a per-thread buffer, and is folded into scalars before the next tile,
+      so the Nn x 3 field is never stored
+    - Every tile is folded into its own Reduction (in double precision), and
+      the tiles are merged in order at the end, so the result does not
+      depend on the number of threads
+    - Nodes with a singular pair are left out of the reductions under
+      SINGULAR_FLAG (their field would be NaN), and counted in nflagged
+*/
+
+#ifndef WIRED_REDUCE_H
+#define WIRED_REDUCE_H
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "parallel.h"      // TileField
+
+// Match the Reduction definition in Julia. Weights w default to 1 and normals
+//  n to 0; max and min are not weighted. No infinities are used as initial
+//  values, since -ffast-math assumes there are none
+typedef struct {
+    double wsum;        // sum of w
+    double Bsum[3];     // sum of w B
+    double B1;          // sum of w |B|
+    double B2;          // sum of w |B|^2
+    double flux;        // sum of w (B . n)
+    double max;         // largest |B| (0 if no node)
+    double min;         // smallest |B| (0 if no node)
+    long long argmax;   // node (0-based) of the largest |B|, -1 if none
+    long long argmin;   // node (0-based) of the smallest |B|, -1 if none
+    long long nsing;    // number of singular node/source pairs
+    long long nflagged; // number of nodes left out (SINGULAR_FLAG)
+} Reduction;
+
+static inline void reduction_init(Reduction* r) {
+    memset(r, 0, sizeof(Reduction));
+    r->argmax = -1;
+    r->argmin = -1;
+}
+
+// Fold the field of nodes j0, ..., j0+n-1 into r
+static void reduction_fold(Reduction* r, const REAL* Bx, const REAL* By, const REAL* Bz,
+                           const double* w, const double* nx, const double* ny, const double* nz,
+                           const int* count, int policy, int j0, int n) {
+    for (int j=0; j<n; j++) {
+        r->nsing += count[j];
+        if (policy == SINGULAR_FLAG && count[j] > 0) {
+            r->nflagged++;
+            continue;
+        }
+        double wj = w ? w[j0+j] : 1.0;
+        double b2 = (double)Bx[j]*Bx[j] + (double)By[j]*By[j] + (double)Bz[j]*Bz[j];
+        double b = sqrt(b2);
+        r->wsum += wj;
+        r->Bsum[0] += wj*Bx[j];
+        r->Bsum[1] += wj*By[j];
+        r->Bsum[2] += wj*Bz[j];
+        r->B1 += wj*b;
+        r->B2 += wj*b2;
+        if (nx) r->flux += wj*((double)Bx[j]*nx[j0+j] + (double)By[j]*ny[j0+j] + (double)Bz[j]*nz[j0+j]);
+        if (r->argmax < 0 || b > r->max) { r->max = b; r->argmax = j0 + j; }
+        if (r->argmin < 0 || b < r->min) { r->min = b; r->argmin = j0 + j; }
+    }
+}
+
+// Merge s into r (s covers later nodes than r, so ties keep the first node)
+static inline void reduction_merge(Reduction* r, const Reduction* s) {
+    r->wsum += s->wsum;
+    for (int k=0; k<3; k++) r->Bsum[k] += s->Bsum[k];
+    r->B1 += s->B1;
+    r->B2 += s->B2;
+    r->flux += s->flux;
+    if (s->argmax >= 0 && (r->argmax < 0 || s->max > r->max)) {
+        r->max = s->max;
+        r->argmax = s->argmax;
+    }
+    if (s->argmin >= 0 && (r->argmin < 0 || s->min < r->min)) {
+        r->min = s->min;
+        r->argmin = s->argmin;
+    }
+    r->nsing += s->nsing;
+    r->nflagged += s->nflagged;
+}
+
+/*
+    reduce_tiles(out, field, ctx, x, y, z, w, nx, ny, nz, Nn, tile, policy, Nt)
+
+Evaluate the field of Nn nodes tile by tile on Nt threads and reduce it into
+out. w (node weights) and nx, ny, nz (node normals) are double in both
+precisions, so they reach the sums unrounded, and may be NULL. Returns 0 on
+success.
+*/
+static int reduce_tiles(Reduction* out, TileField field, const void* ctx,
+                        const REAL* x, const REAL* y, const REAL* z, const double* w,
+                        const double* nx, const double* ny, const double* nz,
+                        int Nn, int tile, int policy, int Nt) {
+    reduction_init(out);
+    if (Nn <= 0) return 0;
+    if (tile < 1) tile = 4096;
+    if (tile > Nn) tile = Nn;
+    if (Nt < 1) Nt = 1;
+
+    int Ntiles = (Nn + tile - 1)/tile;
+    Reduction* part = malloc((size_t)Ntiles*sizeof(Reduction));
+    if (!part) return 1;
+    int status = 0;
+
+    #pragma omp parallel num_threads(Nt) reduction(|:status)
+    {
+        REAL* B = malloc(3*(size_t)tile*sizeof(REAL));
+        int* count = malloc((size_t)tile*sizeof(int));
+        if (!B || !count) status |= 1;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int k=0; k<Ntiles; k++) {
+            int j0 = k*tile;
+            int n = (j0 + tile <= Nn) ? tile : Nn - j0;
+            reduction_init(&part[k]);
+            if (!B || !count) continue;
+            memset(count, 0, (size_t)n*sizeof(int));
+            status |= field(B, B + tile, B + 2*tile, x + j0, y + j0, z + j0, n, count, ctx);
+            reduction_fold(&part[k], B, B + tile, B + 2*tile, w, nx, ny, nz, count, policy, j0, n);
+        }
+
+        free(B);
+        free(count);
+    }
+
+    for (int k=0; k<Ntiles; k++) reduction_merge(out, &part[k]);
+    free(part);
+
+    return status;
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*  Reference kernel for Wired.jl - Extended Precision
+
+    Notes
+    - For validation only: every quantity is computed in long double (80-bit
+      extended precision on x86) and rounded to double at the end
+    - Built without -ffast-math, so the evaluation order and IEEE semantics
+      are as written
+    - Same physical model as the production kernels (wires and circular rings,
+      current density correction inside conductors), with the singular points
+      replaced by their limits: zero on a wire axis and at a ring filament, and
+      zero x and y components on the axis of a ring
+    - Near the axis of a wire, beyond its ends, the field is evaluated in a
+      form free of cancellation, so the reference stays accurate there
+*/
+
+#include <math.h>
+#include <float.h>
+#include <omp.h>
+
+// Match the Wire and Ring definitions in the production kernels
+typedef struct {
+    double a0[3];
+    double a1[3];
+    double I;
+    double R;
+} Wire;
+
+typedef struct {
+    double H;
+    double R;
+    double r;
+    double I;
+} Ring;
+
+static const long double pi_ref = 3.141592653589793238462643383279502884L;
+
+
+/*
+    ellipKE_ref(m, K, E)
+
+Complete elliptic integrals of the first and second kind (parameter m = k^2)
+by the arithmetic-geometric mean, iterated to the precision of long double.
+*/
+static void ellipKE_ref(long double m, long double* K, long double* E) {
+    long double a = 1.0L;
+    long double g = sqrtl(1.0L - m);
+    long double sum = 0.5L*m;
+    long double p = 0.5L;
+
+    for (int it=0; it<64; it++) {
+        long double c = 0.5L*(a - g);
+        long double an = 0.5L*(a + g);
+        g = sqrtl(a*g);
+        a = an;
+        p *= 2;
+        sum += p*c*c;
+        if (fabsl(c) <= LDBL_EPSILON*a) break;
+    }
+
+    *K = pi_ref/(2*a);
+    *E = *K*(1.0L - sum);
+}
+
+
+/*
+    bfield_wires_ref(Bx, By, Bz, x, y, z, wires, Nn, Nw, mu_r, check_inside)
+
+Extended-precision counterpart of `bfield_wires`. The output arrays are
+overwritten; nodes are split across OpenMP threads.
+*/
+int bfield_wires_ref(double* Bx, double* By, double* Bz,
+                const double* x, const double* y, const double* z,
+                const Wire* wires, int Nn, int Nw, double mu_r, int check_inside)
+{
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int j=0; j<Nn; j++) {
+        long double B[3] = {0};
+
+        for (int i=0; i<Nw; i++) {
+            long double d = (long double)mu_r * 1e-7L * wires[i].I;
+            long double a[3], b[3], c[3];
+            for (int k=0; k<3; k++) {
+                a[k] = (long double)wires[i].a1[k] - wires[i].a0[k];
+                b[k] = (long double)wires[i].a0[k] - (k == 0 ? x[j] : k == 1 ? y[j] : z[j]);
+                c[k] = (long double)wires[i].a1[k] - (k == 0 ? x[j] : k == 1 ? y[j] : z[j]);
+            }
+
+            long double cxa[3] = {c[1]*a[2] - c[2]*a[1], c[2]*a[0] - c[0]*a[2], c[0]*a[1] - c[1]*a[0]};
+            long double n2 = cxa[0]*cxa[0] + cxa[1]*cxa[1] + cxa[2]*cxa[2];
+            if (n2 == 0) continue;
+
+            long double a2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+            long double ac = a[0]*c[0] + a[1]*c[1] + a[2]*c[2];
+            long double ab = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+            long double nc = sqrtl(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+            long double nb = sqrtl(b[0]*b[0] + b[1]*b[1] + b[2]*b[2]);
+
+            // Beyond either end, a.c/|c| - a.b/|b| cancels; it equals 
+            //  n2 (a.c + a.b) / (|c| |b| (a.c |b| + a.b |c|)), which does not
+            long double f;
+            if (ac*ab > 0) f = d*(ac + ab)/(nc*nb*(ac*nb + ab*nc));
+            else f = d/n2*(ac/nc - ab/nb);
+
+            // Current density correction inside the conductor
+            long double R = wires[i].R;
+            long double rp2 = n2/a2;
+            if (check_inside && rp2 < R*R && ab <= 0 && -ab <= a2) f *= rp2/(R*R);
+
+            for (int k=0; k<3; k++) B[k] += f*cxa[k];
+        }
+
+        Bx[j] = (double)B[0];
+        By[j] = (double)B[1];
+        Bz[j] = (double)B[2];
+    }
+
+    return 0;
+}
+
+
+/*
+    bfield_rings_ref(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, check_inside)
+
+Extended-precision counterpart of `bfield_rings`. The output arrays are
+overwritten; nodes are split across OpenMP threads.
+*/
+int bfield_rings_ref(double* Bx, double* By, double* Bz,
+                const double* x, const double* y, const double* z,
+                const Ring* rings, int Nn, int Nr, double mu_r, int check_inside)
+{
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int j=0; j<Nn; j++) {
+        long double B[3] = {0};
+        long double xj = x[j], yj = y[j];
+        long double rho2 = xj*xj + yj*yj;
+        long double rho = sqrtl(rho2);
+
+        for (int i=0; i<Nr; i++) {
+            long double C = (long double)mu_r * 4e-7L * rings[i].I;
+            long double R = rings[i].R;
+            long double zr = (long double)z[j] - rings[i].H;
+            long double r2 = rho2 + zr*zr;
+            long double alpha2 = (rho - R)*(rho - R) + zr*zr;
+            if (alpha2 == 0) continue;
+
+            long double beta2 = R*R + r2 + 2*R*rho;
+            long double beta = sqrtl(beta2);
+            long double K, E;
+            ellipKE_ref(1.0L - alpha2/beta2, &K, &E);
+
+            long double jc = 1.0L;
+            long double r = rings[i].r;
+            if (check_inside && alpha2 < r*r) jc = alpha2/(r*r);
+
+            if (rho2 > 0) {
+                long double f = C*zr/(2*alpha2*beta*rho2)*((R*R + r2)*E - alpha2*K);
+                B[0] += jc*xj*f;
+                B[1] += jc*yj*f;
+            }
+            B[2] += jc*C/(2*alpha2*beta)*((R*R - r2)*E + alpha2*K);
+        }
+
+        Bx[j] = (double)B[0];
+        By[j] = (double)B[1];
+        Bz[j] = (double)B[2];
+    }
+
+    return 0;
+}
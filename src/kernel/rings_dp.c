@@ -6,12 +6,21 @@
     - Threads are managed by Julia
 */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <time.h>
 
+#define REAL double
+#include "parallel.h"
+#include "celllist.h"
+#include "quadrature.h"
+#include "grid.h"
+#include "singular.h"
+#include "reduce.h"
+
 #define ITMAX 100 
 #define ERRMAX 1e-12
 const double pi = M_PI;        // for readability
@@ -105,51 +114,162 @@ double ellipE(double k2) {
     return E;
 }
 
-int bfield_rings(double* restrict Bx, double* restrict By, double* restrict Bz, double* restrict x, double* restrict y, double* restrict z, 
-                Ring* restrict rings, int Nn, int Nr, double mu_r, int check_inside)
+/*
+    inside_rings(pairs, x, y, z, rings, Nn, Nr)
+
+Find the node/ring pairs where the node lies inside the conductor (within the 
+minor radius r of the ring filament) using a cell list over the nodes, and 
+store the current density correction factor jc = (alpha/r)^2 for each, where 
+alpha is the distance from the node to the filament. Returns nonzero, with 
+the list freed, if it runs out of memory.
+*/
+static int inside_rings(PairList* pairs, const double* x, const double* y, const double* z, 
+                        const Ring* rings, int Nn, int Nr)
+{
+    CellList cl;
+    if (pairlist_init(pairs, Nr) || celllist_build(&cl, x, y, z, Nn)) {
+        pairlist_free(pairs);
+        return 1;
+    }
+    int nomem = 0;
+    double halfdiag = 0.8660254037844386 * cl.h;
+
+    for (int i=0; i<Nr; i++) {
+        double R = rings[i].R;
+        double H = rings[i].H;
+        double r = rings[i].r;
+        double lo[3] = {-(R + r), -(R + r), H - r};
+        double hi[3] = {R + r, R + r, H + r};
+        int c0[3], c1[3];
+
+        if (r > 0 && R > 0 && celllist_range(&cl, lo, hi, c0, c1)) {
+            for (int k2=c0[2]; k2<=c1[2]; k2++) {
+            for (int k1=c0[1]; k1<=c1[1]; k1++) {
+            for (int k0=c0[0]; k0<=c1[0]; k0++) {
+
+                // Skip cells that cannot touch the conductor
+                double xc = cl.lo[0] + (k0 + 0.5)*cl.h;
+                double yc = cl.lo[1] + (k1 + 0.5)*cl.h;
+                double zc = cl.lo[2] + (k2 + 0.5)*cl.h;
+                double drho = sqrt(xc*xc + yc*yc) - R;
+                if (sqrt(drho*drho + (zc - H)*(zc - H)) > r + halfdiag) continue;
+
+                int c = (k2*cl.n[1] + k1)*cl.n[0] + k0;
+                for (int k=cl.start[c]; k<cl.start[c+1]; k++) {
+                    int j = cl.idx[k];
+                    drho = sqrt((double)x[j]*x[j] + (double)y[j]*y[j]) - R;
+                    double alpha2 = drho*drho + (z[j] - H)*(z[j] - H);
+                    if (alpha2 < r*r) nomem |= pairlist_push(pairs, j, alpha2/(r*r));
+                }
+            }
+            }
+            }
+        }
+
+        pairs->ptr[i+1] = pairs->n;
+    }
+
+    celllist_free(&cl);
+    if (nomem) pairlist_free(pairs);
+    return nomem;
+}
+
+/*
+    rings_kernel(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, check_inside, policy, nsing, I, M)
+
+Calculate the Bfield contributions of a series of rings at a sequence of node 
+points (x,y,z), adding them to (Bx, By, Bz). If I is given (Nr x M), the ring 
+currents are replaced by M sets of currents and M fields are accumulated in 
+(Bx, By, Bz), each Nn long, from one evaluation of the elliptic integrals. 
+Pairs with the node on the ring filament are treated according to `policy` and 
+counted per node in nsing if given (see singular.h); on the axis the x and y 
+components take their limit, zero.
+*/
+static int rings_kernel(double* restrict Bx, double* restrict By, double* restrict Bz, double* restrict x, double* restrict y, double* restrict z, 
+                Ring* restrict rings, int Nn, int Nr, double mu_r, int check_inside, 
+                int policy, int* nsing, const double* I, int M)
 {
-    double* rho = aligned_alloc(32, 32*Nn);
-    double* rho2 = aligned_alloc(32, 32*Nn);
-    double* r2 = aligned_alloc(32, 32*Nn);
-    double* alpha2 = aligned_alloc(32, 32*Nn);
-    double* beta = aligned_alloc(32, 32*Nn);
-    double* beta2 = aligned_alloc(32, 32*Nn);
-    double* k2 = aligned_alloc(32, 32*Nn);
-    double* K = aligned_alloc(32, 32*Nn);
-    double* E = aligned_alloc(32, 32*Nn);
-    double* _Bx = aligned_alloc(32, 32*Nn);
-    double* _By = aligned_alloc(32, 32*Nn); 
-    double* _Bz = aligned_alloc(32, 32*Nn);
-    double* jc; 
-    if (check_inside > 0) jc = aligned_alloc(32, 32*Nn);
-    double C, R, R2, a2;
+    size_t ld = ((size_t)Nn + 15) & ~(size_t)15;
+    double* work = aligned_alloc(64, 15 * ld * sizeof(double) + 64);
+    double* rho = work + 0*ld;
+    double* rho2 = work + 1*ld;
+    double* r2 = work + 2*ld;
+    double* alpha2 = work + 3*ld;
+    double* beta = work + 4*ld;
+    double* beta2 = work + 5*ld;
+    double* k2 = work + 6*ld;
+    double* K = work + 7*ld;
+    double* E = work + 8*ld;
+    double* _Bx = work + 9*ld;
+    double* _By = work + 10*ld;
+    double* _Bz = work + 11*ld;
+    double* zr = work + 12*ld;
+    double* irho2 = work + 13*ld;
+    double* sing = work + 14*ld;
+    double C, R, R2, H;
+    double tol2 = singular_tol2(policy);
+    PairList pairs = {0};
+
+    // exit if any of the inputs don't exist
+    if (!(work && x && y && z && rings)) {
+        printf("error!\n");
+        free(work);
+        return 1;
+    }
+
+    // Find the node/ring pairs that need the current density correction up 
+    //  front, so that the loops below stay branch-free for every other pair
+    if (check_inside > 0 && inside_rings(&pairs, x, y, z, rings, Nn, Nr)) {
+        printf("error!\n");
+        free(work);
+        return 1;
+    }
+    int* count = singular_counts(nsing, policy, Nn);
+    if (singular_nomem(count, policy)) {
+        printf("error!\n");
+        pairlist_free(&pairs);
+        free(work);
+        return 1;
+    }
 
     // Calculate the node variables first
+    // On the axis (rho = 0) the x and y components are zero
     for (int j=0; j<Nn; j++) {
         rho2[j] = x[j]*x[j] + y[j]*y[j];
         rho[j] = sqrt(rho2[j]);
-    }
-    for (int j=0; j<Nn; j++) {
-        r2[j] = x[j]*x[j] + y[j]*y[j] + z[j]*z[j];
+        irho2[j] = (rho2[j] > 0) ? 1/rho2[j] : 0;
     }
 
     for (int i=0; i<Nr; i++) {
 
         R = rings[i].R;
         R2 = R*R;
-        C = mu_r * (4e-7) * rings[i].I;
+        H = rings[i].H;
+        C = mu_r * (4e-7) * (I ? 1 : rings[i].I);
+
+        // Node positions relative to the plane of the ring
+        for (int j=0; j<Nn; j++) {
+            zr[j] = z[j] - H;
+            r2[j] = rho2[j] + zr[j]*zr[j];
+        }
 
         // Calculuate alpha, beta, k2, and elliptic integrals now 
+        // alpha is the distance to the ring filament; computing it directly 
+        //  (not as R^2 + r^2 - 2R*rho) keeps it non-negative near the filament
         for (int j=0; j<Nn; j++) {
-            alpha2[j] = R2 + r2[j] - 2*R*rho[j];
+            alpha2[j] = (rho[j] - R)*(rho[j] - R) + zr[j]*zr[j];
         }
         for (int j=0; j<Nn; j++) {
             beta2[j] = R2 + r2[j] + 2*R*rho[j];     // todo opt based on alpha2?
             beta[j] = sqrt(beta2[j]);
         }
+        // On the filament (to working precision for SINGULAR_LIMIT and SINGULAR_FLAG) 
+        //  the pair is singular; its k2 is replaced by 0 and its field by zero below
         for (int j=0; j<Nn; j++) {
-            k2[j] = 1 - alpha2[j]/beta2[j];
+            sing[j] = !(alpha2[j] > tol2*beta2[j]);
+            k2[j] = sing[j] ? 0 : 1 - alpha2[j]/beta2[j];
         }
+        singular_add(count, sing, Nn);
         for (int j=0; j<Nn; j++) {
             K[j] = ellipK(k2[j]);
         }
@@ -158,50 +278,902 @@ int bfield_rings(double* restrict Bx, double* restrict By, double* restrict Bz,
         }
 
         // Now we have everything we need to calculate B
-        // Bx first 
-        double var1, var2, var3, var4;
+        // Bx and By share the radial component, divided by rho
         for (int j=0; j<Nn; j++) {
-            _Bx[j] = ((C * x[j] * z[j]) / (2*alpha2[j]*beta[j]*rho2[j])) * ((R2 + r2[j]) * E[j] - alpha2[j]*K[j]); 
-        }
-
-        for (int j=0; j<Nn; j++)
-        {
-            _By[j] = (y[j]/x[j]) * _Bx[j];
+            double g = sing[j] ? 0 : C / (2*(sing[j] ? 1 : alpha2[j])*beta[j]);
+            double f = (g * zr[j] * irho2[j]) * ((R2 + r2[j]) * E[j] - alpha2[j]*K[j]); 
+            _Bx[j] = x[j] * f;
+            _By[j] = y[j] * f;
         }
 
         for (int j=0; j<Nn; j++) {
-            _Bz[j] = (C / (2*alpha2[j]*beta[j])) * ((R2 - r2[j]) * E[j] + alpha2[j]*K[j]); 
+            double g = sing[j] ? 0 : C / (2*(sing[j] ? 1 : alpha2[j])*beta[j]);
+            _Bz[j] = g * ((R2 - r2[j]) * E[j] + alpha2[j]*K[j]); 
         }
 
-        // Current density correction
+        // Apply the current density correction to the nodes inside the conductor
         if (check_inside > 0) {
-            // Calculate current density correction 
+            for (int k=pairs.ptr[i]; k<pairs.ptr[i+1]; k++) {
+                int j = pairs.idx[k];
+                double jc = pairs.jc[k];
+                _Bx[j] = (jc > 0) ? jc*_Bx[j] : 0;
+                _By[j] = (jc > 0) ? jc*_By[j] : 0;
+                _Bz[j] = (jc > 0) ? jc*_Bz[j] : 0;
+            }
+        }
+
+        // Copy to output array
+        if (!I) {
             for (int j=0; j<Nn; j++) {
-                jc[j] = (alpha2[j] < a2) ? ((alpha2[j] > 0) ? alpha2[j]/a2 : 0.0) : 1.0;
+                Bx[j] += _Bx[j];
+                By[j] += _By[j];
+                Bz[j] += _Bz[j];
             }
+            continue;
+        }
 
+        // or scale the field per unit current by each set of currents
+        for (int m=0; m<M; m++) {
+            double Im = I[i + (size_t)m*Nr];
+            double* Bxm = Bx + (size_t)m*Nn;
+            double* Bym = By + (size_t)m*Nn;
+            double* Bzm = Bz + (size_t)m*Nn;
             for (int j=0; j<Nn; j++) {
-                _Bx[j] *= jc[j]; 
-                _By[j] *= jc[j]; 
-                _Bz[j] *= jc[j]; 
+                Bxm[j] += Im*_Bx[j];
+                Bym[j] += Im*_By[j];
+                Bzm[j] += Im*_Bz[j];
             }
         }
+    }
 
+    free(work);
+    if (check_inside > 0) pairlist_free(&pairs);
+    singular_finish(Bx, By, Bz, count, nsing, policy, Nn, I ? M : 1);
 
-        // Copy to output array
+    return 0;
+}
+
+
+// Calculate the Bfield generated at a sequence of node points (x,y,z) by a series
+//   of Ring objects; singular pairs are treated according to `policy` and counted 
+//   per node in nsing if given (see singular.h)
+int bfield_rings(double* restrict Bx, double* restrict By, double* restrict Bz, double* restrict x, double* restrict y, double* restrict z, 
+                Ring* restrict rings, int Nn, int Nr, double mu_r, int check_inside, 
+                int policy, int* nsing)
+{
+    return rings_kernel(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, check_inside, policy, nsing, NULL, 1);
+}
+
+
+/*
+    bfield_rings_multi(Bx, By, Bz, x, y, z, rings, I, Nn, Nr, M, mu_r, check_inside, policy, nsing)
+
+Field of the same rings driven by M sets of currents (see `bfield_wires_multi`). 
+I is Nr x M (column-major) and replaces rings[i].I; the elliptic integrals of 
+each node/ring pair are computed once. Bx, By and Bz are Nn x M (column-major), 
+and are accumulated.
+*/
+int bfield_rings_multi(double* Bx, double* By, double* Bz, 
+                const double* x, const double* y, const double* z, 
+                const Ring* rings, const double* I, int Nn, int Nr, int M, 
+                double mu_r, int check_inside, int policy, int* nsing)
+{
+    return rings_kernel(Bx, By, Bz, (double*)x, (double*)y, (double*)z, (Ring*)rings, Nn, Nr, 
+                        mu_r, check_inside, policy, nsing, I, M);
+}
+
+// Sources and options of a reduction over the field of rings
+typedef struct {
+    const Ring* rings;
+    int Nr;
+    double mu_r;
+    int check_inside;
+    int policy;
+} RingsTile;
+
+// Field of one tile of nodes (see reduce.h)
+static int rings_tile(double* Bx, double* By, double* Bz, const double* x, const double* y, const double* z, 
+                      int n, int* count, const void* ctx)
+{
+    const RingsTile* c = ctx;
+    for (int j=0; j<n; j++) {
+        Bx[j] = 0;
+        By[j] = 0;
+        Bz[j] = 0;
+    }
+    return bfield_rings(Bx, By, Bz, (double*)x, (double*)y, (double*)z, (Ring*)c->rings, n, c->Nr, c->mu_r, 
+                        c->check_inside, c->policy, count);
+}
+
+/*
+    bfield_rings_reduce(out, x, y, z, w, nx, ny, nz, rings, Nn, Nr, mu_r, check_inside, policy, tile, Nt)
+
+Reduce the field of the rings at Nn nodes to the scalars of a Reduction without 
+storing it; see `bfield_wires_reduce`.
+*/
+int bfield_rings_reduce(Reduction* out, const double* x, const double* y, const double* z, 
+                const double* w, const double* nx, const double* ny, const double* nz, 
+                const Ring* rings, int Nn, int Nr, double mu_r, int check_inside, 
+                int policy, int tile, int Nt)
+{
+    RingsTile ctx = {rings, Nr, mu_r, check_inside, policy};
+    return reduce_tiles(out, rings_tile, &ctx, x, y, z, w, nx, ny, nz, Nn, tile, policy, Nt);
+}
+
+/*
+    bfield_rings_parallel(...)
+
+Native (OpenMP) parallel mode for ring sources; see `bfield_wires_parallel`. 
+Nodes are partitioned across threads, the output arrays are overwritten, and 
+per-thread placement and timing are reported in `stats`.
+*/
+int bfield_rings_parallel(double* Bx, double* By, double* Bz, 
+                const double* x, const double* y, const double* z, 
+                const Ring* rings, int Nn, int Nr, double mu_r, int check_inside,
+                int policy, int* nsing,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    RingsTile ctx = {rings, Nr, mu_r, check_inside, policy};
+    return field_parallel(Bx, By, Bz, x, y, z, Nn, nsing, rings_tile, &ctx, opts, cpus, stats);
+}
+
+/*
+    OrientedRing 
+A circular current-carrying ring with centre c, unit normal n (the direction 
+of its axis), major radius R, minor radius r, and total current I.
+*/
+typedef struct {
+    double c[3];
+    double n[3];
+    double R; 
+    double r;
+    double I;
+} OrientedRing;
+
+/*
+    inside_oriented_rings(pairs, x, y, z, rings, Nn, Nr)
+
+As `inside_rings`, for rings with an arbitrary centre and axis.
+*/
+static int inside_oriented_rings(PairList* pairs, const double* x, const double* y, const double* z, 
+                        const OrientedRing* rings, int Nn, int Nr)
+{
+    CellList cl;
+    if (pairlist_init(pairs, Nr) || celllist_build(&cl, x, y, z, Nn)) {
+        pairlist_free(pairs);
+        return 1;
+    }
+    int nomem = 0;
+    double halfdiag = 0.8660254037844386 * cl.h;
+
+    for (int i=0; i<Nr; i++) {
+        const double* c = rings[i].c;
+        const double* n = rings[i].n;
+        double R = rings[i].R;
+        double r = rings[i].r;
+        double lo[3], hi[3];
+        int c0[3], c1[3];
+
+        // The circle extends R*sqrt(1 - n[d]^2) from the centre along axis d
+        for (int d=0; d<3; d++) {
+            double ext = R*sqrt(fmax(1 - n[d]*n[d], 0)) + r;
+            lo[d] = c[d] - ext;
+            hi[d] = c[d] + ext;
+        }
+
+        if (r > 0 && R > 0 && celllist_range(&cl, lo, hi, c0, c1)) {
+            for (int k2=c0[2]; k2<=c1[2]; k2++) {
+            for (int k1=c0[1]; k1<=c1[1]; k1++) {
+            for (int k0=c0[0]; k0<=c1[0]; k0++) {
+
+                // Skip cells that cannot touch the conductor
+                double dc[3] = {cl.lo[0] + (k0 + 0.5)*cl.h - c[0], 
+                                cl.lo[1] + (k1 + 0.5)*cl.h - c[1], 
+                                cl.lo[2] + (k2 + 0.5)*cl.h - c[2]};
+                double zc = dc[0]*n[0] + dc[1]*n[1] + dc[2]*n[2];
+                double drho = sqrt(fmax(dc[0]*dc[0] + dc[1]*dc[1] + dc[2]*dc[2] - zc*zc, 0)) - R;
+                if (sqrt(drho*drho + zc*zc) > r + halfdiag) continue;
+
+                int cell = (k2*cl.n[1] + k1)*cl.n[0] + k0;
+                for (int k=cl.start[cell]; k<cl.start[cell+1]; k++) {
+                    int j = cl.idx[k];
+                    double d[3] = {x[j] - c[0], y[j] - c[1], z[j] - c[2]};
+                    double zl = d[0]*n[0] + d[1]*n[1] + d[2]*n[2];
+                    drho = sqrt(fmax(d[0]*d[0] + d[1]*d[1] + d[2]*d[2] - zl*zl, 0)) - R;
+                    double alpha2 = drho*drho + zl*zl;
+                    if (alpha2 < r*r) nomem |= pairlist_push(pairs, j, alpha2/(r*r));
+                }
+            }
+            }
+            }
+        }
+
+        pairs->ptr[i+1] = pairs->n;
+    }
+
+    celllist_free(&cl);
+    if (nomem) pairlist_free(pairs);
+    return nomem;
+}
+
+/*
+    bfield_oriented_rings(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, check_inside, policy, nsing)
+
+Calculate the Bfield generated at a sequence of node points (x,y,z) by a series 
+of rings with arbitrary centre and axis, adding it to (Bx, By, Bz).
+
+Each node is moved into the frame of the ring as its height zl = (p - c).n along 
+the axis and its radial offset u = (p - c) - zl*n from the axis; the field is then 
+B = (B_rho/rho)*u + B_z*n, so no rotation matrix is needed and every loop over 
+the nodes is branch-free. Singular pairs are treated as in `bfield_rings`.
+*/
+int bfield_oriented_rings(double* restrict Bx, double* restrict By, double* restrict Bz, 
+                const double* restrict x, const double* restrict y, const double* restrict z, 
+                const OrientedRing* restrict rings, int Nn, int Nr, double mu_r, int check_inside, 
+                int policy, int* nsing)
+{
+    size_t ld = ((size_t)Nn + 15) & ~(size_t)15;
+    double* work = aligned_alloc(64, 14 * ld * sizeof(double) + 64);
+    double* ux = work + 0*ld;
+    double* uy = work + 1*ld;
+    double* uz = work + 2*ld;
+    double* zl = work + 3*ld;
+    double* rho = work + 4*ld;
+    double* r2 = work + 5*ld;
+    double* alpha2 = work + 6*ld;
+    double* beta = work + 7*ld;
+    double* k2 = work + 8*ld;
+    double* K = work + 9*ld;
+    double* E = work + 10*ld;
+    double* f = work + 11*ld;
+    double* bz = work + 12*ld;
+    double* sing = work + 13*ld;
+    double tol2 = singular_tol2(policy);
+    PairList pairs = {0};
+
+    // exit if any of the inputs don't exist
+    if (!(work && x && y && z && rings)) {
+        printf("error!\n");
+        free(work);
+        return 1;
+    }
+
+    if (check_inside > 0 && inside_oriented_rings(&pairs, x, y, z, rings, Nn, Nr)) {
+        printf("error!\n");
+        free(work);
+        return 1;
+    }
+    int* count = singular_counts(nsing, policy, Nn);
+    if (singular_nomem(count, policy)) {
+        printf("error!\n");
+        pairlist_free(&pairs);
+        free(work);
+        return 1;
+    }
+
+    for (int i=0; i<Nr; i++) {
+
+        const double* c = rings[i].c;
+        const double* n = rings[i].n;
+        double R = rings[i].R;
+        double R2 = R*R;
+        double C = mu_r * (4e-7) * rings[i].I;
+
+        // Transform to the frame of the ring
         for (int j=0; j<Nn; j++) {
-            Bx[j] += _Bx[j];
-            By[j] += _By[j];
-            Bz[j] += _Bz[j];
+            double dx = x[j] - c[0];
+            double dy = y[j] - c[1];
+            double dz = z[j] - c[2];
+            zl[j] = dx*n[0] + dy*n[1] + dz*n[2];
+            ux[j] = dx - zl[j]*n[0];
+            uy[j] = dy - zl[j]*n[1];
+            uz[j] = dz - zl[j]*n[2];
+        }
+        for (int j=0; j<Nn; j++) {
+            double rho2 = ux[j]*ux[j] + uy[j]*uy[j] + uz[j]*uz[j];
+            rho[j] = sqrt(rho2);
+            r2[j] = rho2 + zl[j]*zl[j];
+            alpha2[j] = (rho[j] - R)*(rho[j] - R) + zl[j]*zl[j];
+            double beta2 = R2 + r2[j] + 2*R*rho[j];
+            beta[j] = sqrt(beta2);
+            sing[j] = !(alpha2[j] > tol2*beta2);
+            k2[j] = sing[j] ? 0 : 1 - alpha2[j]/beta2;
+        }
+        singular_add(count, sing, Nn);
+        for (int j=0; j<Nn; j++) {
+            K[j] = ellipK(k2[j]);
+        }
+        for (int j=0; j<Nn; j++) {
+            E[j] = ellipE(k2[j]);
+        }
+
+        // Radial component divided by rho (zero on the axis), and axial component
+        for (int j=0; j<Nn; j++) {
+            double rho2 = rho[j]*rho[j];
+            double irho2 = (rho2 > 0) ? 1/rho2 : 0;
+            double g = sing[j] ? 0 : C / (2*(sing[j] ? 1 : alpha2[j])*beta[j]);
+            f[j] = g * zl[j] * irho2 * ((R2 + r2[j]) * E[j] - alpha2[j]*K[j]);
+            bz[j] = g * ((R2 - r2[j]) * E[j] + alpha2[j]*K[j]);
+        }
+
+        // Apply the current density correction to the nodes inside the conductor
+        if (check_inside > 0) {
+            for (int k=pairs.ptr[i]; k<pairs.ptr[i+1]; k++) {
+                int j = pairs.idx[k];
+                double jc = pairs.jc[k];
+                f[j] = (jc > 0) ? jc*f[j] : 0;
+                bz[j] = (jc > 0) ? jc*bz[j] : 0;
+            }
+        }
+
+        // Rotate back to the global frame and add to the output array
+        for (int j=0; j<Nn; j++) {
+            Bx[j] += f[j]*ux[j] + bz[j]*n[0];
+            By[j] += f[j]*uy[j] + bz[j]*n[1];
+            Bz[j] += f[j]*uz[j] + bz[j]*n[2];
         }
     }
 
-    free(rho); free(rho2); free(r2); free(alpha2); free(beta2); free(k2); 
-    free(K); free(E); free(_Bx); free(_By); free(_Bz);
+    free(work);
+    if (check_inside > 0) pairlist_free(&pairs);
+    singular_finish(Bx, By, Bz, count, nsing, policy, Nn, 1);
 
     return 0;
 }
 
+
+// Sources and options of a natively parallel evaluation of oriented rings
+typedef struct {
+    const OrientedRing* rings;
+    int Nr;
+    double mu_r;
+    int check_inside;
+    int policy;
+} OrientedRingsTile;
+
+// Field of one partition of nodes (see parallel.h)
+static int oriented_rings_tile(double* Bx, double* By, double* Bz, const double* x, const double* y, const double* z, 
+                               int n, int* count, const void* ctx)
+{
+    const OrientedRingsTile* c = ctx;
+    for (int j=0; j<n; j++) {
+        Bx[j] = 0;
+        By[j] = 0;
+        Bz[j] = 0;
+    }
+    return bfield_oriented_rings(Bx, By, Bz, x, y, z, c->rings, n, c->Nr, c->mu_r, c->check_inside, 
+                                 c->policy, count);
+}
+
+
+/*
+    bfield_oriented_rings_parallel(...)
+
+Native (OpenMP) parallel mode for oriented ring sources; see 
+`bfield_wires_parallel`. The output arrays are overwritten.
+*/
+int bfield_oriented_rings_parallel(double* Bx, double* By, double* Bz, 
+                const double* x, const double* y, const double* z, 
+                const OrientedRing* rings, int Nn, int Nr, double mu_r, int check_inside,
+                int policy, int* nsing,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    OrientedRingsTile ctx = {rings, Nr, mu_r, check_inside, policy};
+    return field_parallel(Bx, By, Bz, x, y, z, Nn, nsing, oriented_rings_tile, &ctx, opts, cpus, stats);
+}
+
+
+/*
+    RectangularRing 
+A circular current-carrying ring with height above XY plane H, major radius R, 
+rectangular cross-section of width w and height h, and total current I.
+*/
+typedef struct {
+    double H;
+    double R; 
+    double w;
+    double h;
+    double I;
+} RectangularRing;
+
+/*
+    filament_field(a, rho, zr, f, bz)
+
+Field of a filament ring of radius a, per unit C = mu0*I/pi, at in-plane radius 
+rho and height zr above its plane: f = B_rho/rho (zero on the axis) and bz = B_z.
+*/
+static inline void filament_field(double a, double rho, double zr, double* f, double* bz) {
+    double rho2 = rho*rho;
+    double r2 = rho2 + zr*zr;
+    double alpha2 = (rho - a)*(rho - a) + zr*zr;
+    double beta2 = (rho + a)*(rho + a) + zr*zr;
+
+    // On the filament itself
+    if (!(alpha2 > 0)) {
+        *f = 0;
+        *bz = 0;
+        return;
+    }
+
+    double k2 = 1 - alpha2/beta2;
+    double K = ellipK(k2);
+    double E = ellipE(k2);
+    double g = 1 / (2*alpha2*sqrt(beta2));
+    *f = (rho2 > 0) ? g * zr * ((a*a + r2) * E - alpha2*K) / rho2 : 0;
+    *bz = g * ((a*a - r2) * E + alpha2*K);
+}
+
+/*
+    rect_polar(pu, pv, u0, u1, v0, v1, rho, zr, xq, wq, n, f, bz)
+
+Integrate the filament field at (rho, zr) over the cross-section [u0,u1] x [v0,v1]
+(radius u, height v), in polar coordinates about the point (pu, pv). The 
+rectangle is split into one signed triangle per edge with a corner at (pu, pv), 
+which cancels the 1/distance singularity of the integrand at that point. Used for
+nodes inside or close to the conductor, with (pu, pv) = (rho, zr).
+*/
+static void rect_polar(double pu, double pv, double u0, double u1, double v0, double v1, 
+                        double rho, double zr, const double* xq, const double* wq, int n, 
+                        double* f, double* bz)
+{
+    double cu[5] = {u0, u1, u1, u0, u0};
+    double cv[5] = {v0, v0, v1, v1, v0};
+
+    for (int e=0; e<4; e++) {
+        double au = cu[e] - pu;
+        double av = cv[e] - pv;
+        double bu = cu[e+1] - pu;
+        double bv = cv[e+1] - pv;
+        double L = sqrt((bu - au)*(bu - au) + (bv - av)*(bv - av));
+        double su = (bu - au)/L;
+        double sv = (bv - av)/L;
+
+        // Foot of the perpendicular from the point to the edge line
+        double tA = au*su + av*sv;
+        double nu = au - tA*su;
+        double nv = av - tA*sv;
+        double d = sqrt(nu*nu + nv*nv);
+        if (!(d > 1e-12*L)) continue;
+        nu /= d;
+        nv /= d;
+
+        // Angle from the perpendicular theta = atan(sinh(s)), which keeps the
+        //  integrand smooth when the point is close to a long edge
+        double sgn = (au*bv - av*bu > 0) ? 1 : -1;
+        double sA = asinh(tA/d);
+        double sB = asinh((tA + L)/d);
+        double sm = 0.5*(sA + sB);
+        double sh = 0.5*(sB - sA);
+
+        for (int kt=0; kt<n; kt++) {
+            double ch = cosh(sm + sh*xq[kt]);
+            double c = 1/ch;
+            double s = tanh(sm + sh*xq[kt]);
+            double rmax = d*ch;
+            double ru = c*nu + s*su;
+            double rv = c*nv + s*sv;
+            for (int kr=0; kr<n; kr++) {
+                double r = 0.5*rmax*(1 + xq[kr]);
+                double fk, bzk;
+                filament_field(pu + r*ru, rho, zr - (pv + r*rv), &fk, &bzk);
+                double wk = sgn * wq[kt]*sh*c * wq[kr]*0.5*rmax * r;
+                *f += wk*fk;
+                *bz += wk*bzk;
+            }
+        }
+    }
+}
+
+/*
+    bfield_rect_rings(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, tol)
+
+Calculate the Bfield generated at a sequence of node points (x,y,z) by a series 
+of rings with rectangular cross-section, adding it to (Bx, By, Bz). 
+
+The uniform current density is integrated over the cross-section with a tensor 
+Gauss-Legendre rule of filament rings, chosen per node: with t = (half diagonal 
+of the cross-section)/(distance to its centre), the lowest order n in 2, 4, 8, 16 
+with t^(2n) < tol is used. Nodes within two half diagonals of the centre 
+(including nodes inside the conductor) use an order 16 rule in polar coordinates 
+about the node (see `rect_polar`). No filaments are stored.
+*/
+int bfield_rect_rings(double* restrict Bx, double* restrict By, double* restrict Bz, 
+                const double* restrict x, const double* restrict y, const double* restrict z, 
+                const RectangularRing* restrict rings, int Nn, int Nr, double mu_r, double tol)
+{
+    double qx[GL_NRULES][16], qw[GL_NRULES][16];
+    for (int q=0; q<GL_NRULES; q++) gl_rule(q, qx[q], qw[q]);
+
+    // exit if any of the inputs don't exist
+    if (!(x && y && z && rings)) {
+        printf("error!\n");
+        return 1;
+    }
+
+    for (int i=0; i<Nr; i++) {
+
+        double R = rings[i].R;
+        double H = rings[i].H;
+        double w = rings[i].w;
+        double h = rings[i].h;
+        double C = mu_r * (4e-7) * rings[i].I;
+        double a = 0.5*sqrt(w*w + h*h);
+
+        for (int j=0; j<Nn; j++) {
+            double rho = sqrt(x[j]*x[j] + y[j]*y[j]);
+            double zr = z[j] - H;
+            double dc = sqrt((rho - R)*(rho - R) + zr*zr);
+
+            double f = 0;
+            double bz = 0;
+            double s;
+
+            if (dc > 2*a) {
+                // Tensor rule of the lowest order that meets the tolerance 
+                int q;
+                double t = a/dc;
+                for (q=0; q<GL_NRULES-1; q++) {
+                    if (pow(t, 2*gl_order[q]) < tol) break;
+                }
+                for (int ku=0; ku<gl_order[q]; ku++) {
+                for (int kv=0; kv<gl_order[q]; kv++) {
+                    double fk, bzk;
+                    filament_field(R + 0.5*w*qx[q][ku], rho, zr - 0.5*h*qx[q][kv], &fk, &bzk);
+                    double wk = qw[q][ku]*qw[q][kv];
+                    f += wk*fk;
+                    bz += wk*bzk;
+                }
+                }
+
+                // Weights sum to 4
+                s = C/4;
+            }
+            else {
+                rect_polar(rho, zr, R - 0.5*w, R + 0.5*w, -0.5*h, 0.5*h, rho, zr, 
+                            qx[GL_NRULES-1], qw[GL_NRULES-1], gl_order[GL_NRULES-1], &f, &bz);
+                s = C/(w*h);
+            }
+
+            Bx[j] += s*f*x[j];
+            By[j] += s*f*y[j];
+            Bz[j] += s*bz;
+        }
+    }
+
+    return 0;
+}
+
+
+// Sources and options of a natively parallel evaluation of rectangular rings
+typedef struct {
+    const RectangularRing* rings;
+    int Nr;
+    double mu_r;
+    double tol;
+} RectRingsTile;
+
+// Field of one partition of nodes (see parallel.h)
+static int rect_rings_tile(double* Bx, double* By, double* Bz, const double* x, const double* y, const double* z, 
+                           int n, int* count, const void* ctx)
+{
+    const RectRingsTile* c = ctx;
+    for (int j=0; j<n; j++) {
+        Bx[j] = 0;
+        By[j] = 0;
+        Bz[j] = 0;
+    }
+    return bfield_rect_rings(Bx, By, Bz, x, y, z, c->rings, n, c->Nr, c->mu_r, c->tol);
+}
+
+
+/*
+    bfield_rect_rings_parallel(...)
+
+Native (OpenMP) parallel mode for rectangular ring sources; see 
+`bfield_wires_parallel`. The output arrays are overwritten.
+*/
+int bfield_rect_rings_parallel(double* Bx, double* By, double* Bz, 
+                const double* x, const double* y, const double* z, 
+                const RectangularRing* rings, int Nn, int Nr, double mu_r, double tol,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    RectRingsTile ctx = {rings, Nr, mu_r, tol};
+    return field_parallel(Bx, By, Bz, x, y, z, Nn, NULL, rect_rings_tile, &ctx, opts, cpus, stats);
+}
+
+
+/*
+    rings_cylgrid_range(Bx, By, Bz, grid, rings, Nr, mu_r, check_inside, m0, m1)
+
+Add the field of a series of Ring objects at the nodes of a CylindricalGrid with 
+(r, z) index m = i + n[0]*k in m0 ... m1-1, for every azimuth; Bx, By, Bz hold 
+the whole grid.
+
+The rings are coaxial with the grid, so B_rho and B_z are evaluated once per 
+(r, z) and rotated to each azimuth: n[0]*n[2] elliptic integrals per ring instead 
+of n[0]*n[1]*n[2]. The rotations are kept in a heap buffer (the number of 
+azimuths is up to the caller, and OpenMP threads have small stacks). Returns 0 on 
+success.
+*/
+static int rings_cylgrid_range(double* restrict Bx, double* restrict By, double* restrict Bz, 
+                const CylindricalGrid* grid, const Ring* rings, int Nr, double mu_r, 
+                int check_inside, int m0, int m1)
+{
+    int n0 = grid->n[0];
+    int n1 = grid->n[1];
+    double* cphi = malloc(2*(size_t)n1*sizeof(double));
+    if (!cphi) return 1;
+    double* sphi = cphi + n1;
+    for (int j=0; j<n1; j++) {
+        cphi[j] = cos(grid->phi0 + j*grid->dphi);
+        sphi[j] = sin(grid->phi0 + j*grid->dphi);
+    }
+
+    for (int m=m0; m<m1; m++) {
+        int i = m % n0;
+        int k = m / n0;
+        double rho = grid->r0 + i*grid->dr;
+        double z = grid->z0 + k*grid->dz;
+        double Brho = 0;
+        double Bzs = 0;
+
+        for (int s=0; s<Nr; s++) {
+            double zr = z - rings[s].H;
+            double C = mu_r * (4e-7) * rings[s].I;
+            double f, bz;
+            filament_field(rings[s].R, rho, zr, &f, &bz);
+
+            // Apply the current density correction inside the conductor
+            double r = rings[s].r;
+            double alpha2 = (rho - rings[s].R)*(rho - rings[s].R) + zr*zr;
+            double jc = (check_inside > 0 && alpha2 < r*r) ? alpha2/(r*r) : 1;
+
+            Brho += jc*C*f*rho;
+            Bzs += jc*C*bz;
+        }
+
+        for (int j=0; j<n1; j++) {
+            size_t o = (size_t)(k*n1 + j)*n0 + i;
+            Bx[o] += Brho*cphi[j];
+            By[o] += Brho*sphi[j];
+            Bz[o] += Bzs;
+        }
+    }
+
+    free(cphi);
+    return 0;
+}
+
+
+/*
+    bfield_rings_cylgrid(Bx, By, Bz, grid, rings, Nr, mu_r, check_inside)
+
+Calculate the Bfield generated by a series of Ring objects at every node of a 
+CylindricalGrid (about the Z-axis), adding it to (Bx, By, Bz) 
+(n[0]*n[1]*n[2] values each). 
+*/
+int bfield_rings_cylgrid(double* Bx, double* By, double* Bz, const CylindricalGrid* grid, 
+                const Ring* rings, int Nr, double mu_r, int check_inside)
+{
+    // exit if any of the inputs don't exist
+    if (!(grid && rings)) {
+        printf("error!\n");
+        return 1;
+    }
+
+    return rings_cylgrid_range(Bx, By, Bz, grid, rings, Nr, mu_r, check_inside, 0, grid->n[0]*grid->n[2]);
+}
+
+
+// Arrays, grid and sources of a natively parallel CylindricalGrid evaluation
+typedef struct {
+    double* Bx;
+    double* By;
+    double* Bz;
+    const CylindricalGrid* grid;
+    const Ring* rings;
+    int Nr;
+    double mu_r;
+    int check_inside;
+} RingsCylgridWork;
+
+// Field of the (r, z) pairs m0 ... m1-1, for every azimuth (overwritten)
+static int rings_cylgrid_partition(int m0, int m1, const ParallelOptions* opts, const void* ctx)
+{
+    const RingsCylgridWork* c = ctx;
+    int n0 = c->grid->n[0];
+    int n1 = c->grid->n[1];
+
+    // The azimuths of an (r, z) pair are spread through the output; zero (and 
+    //  so first-touch) only those of this partition before adding to them
+    for (int m=m0; m<m1; m++) {
+        int i = m % n0;
+        int k = m / n0;
+        for (int j=0; j<n1; j++) {
+            size_t o = (size_t)(k*n1 + j)*n0 + i;
+            c->Bx[o] = 0;
+            c->By[o] = 0;
+            c->Bz[o] = 0;
+        }
+    }
+    return rings_cylgrid_range(c->Bx, c->By, c->Bz, c->grid, c->rings, c->Nr, c->mu_r, c->check_inside, m0, m1);
+}
+
+
+/*
+    bfield_rings_cylgrid_parallel(...)
+
+Native (OpenMP) parallel mode for CylindricalGrid targets: (r, z) pairs are 
+partitioned across threads as in `bfield_rings_parallel`, and the output arrays 
+are overwritten. The node ranges in `stats` count (r, z) pairs.
+*/
+int bfield_rings_cylgrid_parallel(double* Bx, double* By, double* Bz, const CylindricalGrid* grid, 
+                const Ring* rings, int Nr, double mu_r, int check_inside,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    // exit if any of the inputs don't exist
+    if (!(grid && rings)) {
+        printf("error!\n");
+        return 1;
+    }
+
+    RingsCylgridWork work = {Bx, By, Bz, grid, rings, Nr, mu_r, check_inside};
+    return run_partitions(rings_cylgrid_partition, &work, grid->n[0]*grid->n[2], opts, cpus, stats);
+}
+
+
+/*
+    pair_force(a, b, d, Iq, Ip, fz, fr, dfz)
+
+Force on a filament ring of radius b carrying Ip, due to a coaxial filament ring 
+of radius a carrying Iq, a height d below it (d = z_p - z_q). With the field 
+(B_rho, B_z) of the source ring at (b, d), the axial force is 
+fz = -2pi b Ip B_rho, the total outward (hoop) load is fr = 2pi b Ip B_z, and 
+dfz = d(fz)/dd follows from dK/dm and dE/dm in closed form. Coincident filaments 
+give no force.
+*/
+static inline void pair_force(double a, double b, double d, double Iq, double Ip, 
+                              double* fz, double* fr, double* dfz)
+{
+    double alpha2 = (a-b)*(a-b) + d*d;
+    double beta2 = (a+b)*(a+b) + d*d;
+    if (!(alpha2 > 1e-24*beta2)) {
+        *fz = 0;
+        *fr = 0;
+        *dfz = 0;
+        return;
+    }
+
+    double beta = sqrt(beta2);
+    double m = 1 - alpha2/beta2;
+    double K = ellipK(m);
+    double E = ellipE(m);
+    double s = a*a + b*b + d*d;
+    double C = (4e-7)*pi * Iq * Ip;        // mu0 Iq Ip
+
+    // G = 2pi b beta B_rho / (mu0 Iq d)
+    double G = -K + s/alpha2*E;
+    *fz = -C*d*G/beta;
+    *fr = C*b/beta*(K + (a*a - b*b - d*d)/alpha2*E);
+
+    // dm/dd = -2dm/beta^2, with the 1/m of dK/dm and dE/dm cancelled
+    double dG = d*(E - (1-m)*K)/alpha2 + 2*d*(1/alpha2 - s/(alpha2*alpha2))*E 
+                - s/alpha2*d*(E - K)/beta2;
+    *dfz = -C*((1/beta - d*d/(beta2*beta))*G + d/beta*dG);
+}
+
+
+/*
+    ring_forces(Fz, Fr, K, rings, start, Nc, mu_r, Nt)
+
+Pairwise axial forces, hoop loads and axial stiffness between coils made of 
+coaxial Ring filaments, the filaments of coil i being rings[start[i]] ... 
+rings[start[i+1]-1]. The outputs are Nc x Nc (column-major) and are overwritten: 
+
+- Fz[i + Nc*j]: axial force on coil i due to coil j
+- Fr[i + Nc*j]: total outward radial load on coil i due to coil j
+- K[i + Nc*j]: dFz_i/dz_j, the change of the net axial force on coil i when coil 
+  j moves along the axis (the diagonal holds the stiffness of each coil)
+
+Only pairs of filaments in different coils are included. Filaments are split 
+across Nt OpenMP threads; each one sums over every filament of every other coil.
+Returns nonzero, with the outputs zeroed, if it runs out of memory.
+*/
+int ring_forces(double* Fz, double* Fr, double* K, const Ring* rings, const int* start, 
+                int Nc, double mu_r, int Nt)
+{
+    // exit if any of the inputs don't exist
+    if (!(Fz && Fr && K && rings && start)) {
+        printf("error!\n");
+        return 1;
+    }
+
+    for (long k=0; k<(long)Nc*Nc; k++) {
+        Fz[k] = 0;
+        Fr[k] = 0;
+        K[k] = 0;
+    }
+
+    // Coil of each filament
+    int Nr = start[Nc];
+    int* coil = malloc((size_t)(Nr > 0 ? Nr : 1) * sizeof(int));
+    if (!coil) {
+        printf("error!\n");
+        return 1;
+    }
+    for (int i=0; i<Nc; i++) {
+        for (int p=start[i]; p<start[i+1]; p++) coil[p] = i;
+    }
+
+    #pragma omp parallel for num_threads(Nt) schedule(dynamic, 16)
+    for (int p=0; p<Nr; p++) {
+        int i = coil[p];
+        double diag = 0;
+
+        for (int j=0; j<Nc; j++) {
+            if (j == i) continue;
+            double fz = 0, fr = 0, dfz = 0;
+            for (int q=start[j]; q<start[j+1]; q++) {
+                double f, g, h;
+                pair_force(rings[q].R, rings[p].R, rings[p].H - rings[q].H, 
+                           rings[q].I, rings[p].I, &f, &g, &h);
+                fz += f;
+                fr += g;
+                dfz += h;
+            }
+
+            // Moving coil j up lowers d for each of its pairs with coil i
+            #pragma omp atomic
+            Fz[i + (long)Nc*j] += mu_r*fz;
+            #pragma omp atomic
+            Fr[i + (long)Nc*j] += mu_r*fr;
+            #pragma omp atomic
+            K[i + (long)Nc*j] -= mu_r*dfz;
+            diag += mu_r*dfz;
+        }
+
+        #pragma omp atomic
+        K[i + (long)Nc*i] += diag;
+    }
+
+    free(coil);
+    return 0;
+}
+
+
+/*
+    rect_filaments(fil, rect, Nr, q)
+
+Replace each of Nr rings with rectangular cross-section by the order x order 
+Gauss-Legendre points of its cross-section (order gl_order[q]), as Ring 
+filaments carrying the quadrature weight of the current, for `ring_forces`. 
+`fil` must hold Nr*order^2 rings; the filaments of rect[i] are stored together.
+*/
+int rect_filaments(Ring* fil, const RectangularRing* rect, int Nr, int q)
+{
+    if (q < 0 || q >= GL_NRULES) return 1;
+
+    int n = gl_order[q];
+    double qx[16], qw[16];
+    gl_rule(q, qx, qw);
+
+    int k = 0;
+    for (int i=0; i<Nr; i++) {
+        for (int ku=0; ku<n; ku++) {
+            for (int kv=0; kv<n; kv++) {
+                fil[k].R = rect[i].R + 0.5*rect[i].w*qx[ku];
+                fil[k].H = rect[i].H + 0.5*rect[i].h*qx[kv];
+                fil[k].r = 0;
+                fil[k].I = 0.25*qw[ku]*qw[kv]*rect[i].I;
+                k++;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
 #define NUMRINGS 1000
 #define NUMNODES 1000
 #define NUMIT 100
@@ -248,7 +1220,7 @@ int main() {
         }
 
         start = clock();
-        int val = bfield_rings(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, check_inside);
+        int val = bfield_rings(Bx, By, Bz, x, y, z, rings, Nn, Nr, mu_r, check_inside, SINGULAR_ZERO, NULL);
         stop = clock();
 
         totaltime += (stop - start)/CLOCKS_PER_SEC;
@@ -0,0 +1,88 @@
+/*  Treatment of singular node/source pairs for the Wired.jl C kernel
+
+    Notes
+    - Shared by the wire and ring kernels; REAL must be defined first
+    - A pair is singular when the node lies on the axis of a wire (between its
+      ends) or on the filament of a ring, where the field expressions divide
+      by zero. The policy (Wired.singularity) decides what such pairs add:
+        SINGULAR_ZERO   exactly singular pairs add nothing
+        SINGULAR_LIMIT  pairs that are singular to working precision add their
+                        limiting value, which is zero (it vanishes inside the
+                        conductor, and by symmetry on a bare filament); wire
+                        nodes on the axis beyond the ends are evaluated in a
+                        form that does not cancel, so they are not singular
+        SINGULAR_FLAG   as SINGULAR_LIMIT, but the field of every node with a
+                        singular pair is set to NaN
+    - The tests are selects rather than branches, and no division by zero is
+      ever evaluated, so the loops over the nodes still vectorize and no NaN
+      reaches the outputs (which -ffast-math would not handle reliably)
+    - The number of singular pairs of each node is added to optional counts;
+      SINGULAR_FLAG only flags the nodes of the current call
+*/
+
+#ifndef WIRED_SINGULAR_H
+#define WIRED_SINGULAR_H
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define SINGULAR_ZERO 0
+#define SINGULAR_LIMIT 1
+#define SINGULAR_FLAG 2
+
+// Distance to a singularity, relative to the size of the problem, below which
+//  a pair is singular to working precision (in units of the machine epsilon)
+#define SINGULAR_ULPS 64
+
+// Squared relative distance for a policy: exact zeros only for SINGULAR_ZERO
+static inline REAL singular_tol2(int policy) {
+    REAL eps = (sizeof(REAL) == sizeof(float)) ? FLT_EPSILON : DBL_EPSILON;
+    return (policy == SINGULAR_ZERO) ? 0 : (SINGULAR_ULPS*eps)*(SINGULAR_ULPS*eps);
+}
+
+// Per-node counts for a kernel call: scratch counts if the policy needs the 
+//  counts of this call alone, otherwise the caller's counts (or NULL)
+static inline int* singular_counts(int* nsing, int policy, int Nn) {
+    if (policy == SINGULAR_FLAG) return calloc((size_t)Nn, sizeof(int));
+    return nsing;
+}
+
+// Whether singular_counts could not allocate the scratch counts the policy needs
+static inline int singular_nomem(const int* count, int policy) {
+    return (policy == SINGULAR_FLAG) && !count;
+}
+
+// Add the singular pairs (s[j] = 1) of one source to the counts
+static inline void singular_add(int* count, const REAL* s, int Nn) {
+    if (!count) return;
+    for (int j=0; j<Nn; j++) {
+        count[j] += (int)s[j];
+    }
+}
+
+// Apply SINGULAR_FLAG to M fields of Nn nodes, and add scratch counts to the 
+//  caller's counts before releasing them
+static inline void singular_finish(REAL* Bx, REAL* By, REAL* Bz, int* count,
+                                   int* nsing, int policy, int Nn, int M) {
+    if (!count) return;
+    if (policy == SINGULAR_FLAG) {
+        for (int m=0; m<M; m++) {
+            for (int j=0; j<Nn; j++) {
+                if (count[j] > 0) {
+                    Bx[(size_t)m*Nn + j] = NAN;
+                    By[(size_t)m*Nn + j] = NAN;
+                    Bz[(size_t)m*Nn + j] = NAN;
+                }
+            }
+        }
+    }
+    if (count != nsing) {
+        if (nsing) {
+            for (int j=0; j<Nn; j++) nsing[j] += count[j];
+        }
+        free(count);
+    }
+}
+
+#endif
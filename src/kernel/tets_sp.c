@@ -0,0 +1,215 @@
+/*  Computational kernel for Wired.jl - Tetrahedral Element Sources (Single-Precision)
+
+    Notes
+    - Supports Float32's only
+    - Each element carries a uniform current density; its field is an exact
+      (analytic) volume integral, so no length/radius ratio is assumed and the
+      field is finite and continuous everywhere, including inside the element
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define REAL float
+#include "parallel.h"
+
+// Match the Tetrahedron definition in Julia
+typedef struct {
+    float v[4][3];     // corner nodes
+    float J[3];        // current density
+} Tet;
+
+// Geometry of one triangular face of a Tet, precomputed once per element
+typedef struct {
+    float n[3];        // outward unit normal
+    float p[3][3];     // corners, counter-clockwise about n
+    float s[3][3];     // unit vector along edge e, from p[e] to p[e+1]
+    float m[3][3];     // in-plane unit normal of edge e, pointing out of the face
+    float len[3];      // length of edge e
+} Face;
+
+
+/*
+    tet_faces(faces, tet)
+
+Set up the four faces of a Tet with outward normals. Returns 1 for a
+degenerate (zero-volume) element, which generates no field.
+*/
+static int tet_faces(Face* faces, const Tet* tet) {
+
+    for (int k=0; k<4; k++) {
+        // Face k is opposite corner k
+        const float* a = tet->v[(k+1) % 4];
+        const float* b = tet->v[(k+2) % 4];
+        const float* c = tet->v[(k+3) % 4];
+        const float* o = tet->v[k];
+        Face* f = &faces[k];
+
+        float u[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+        float w[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+        float n[3] = {u[1]*w[2] - u[2]*w[1], u[2]*w[0] - u[0]*w[2], u[0]*w[1] - u[1]*w[0]};
+        float nn = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        float h = n[0]*(o[0]-a[0]) + n[1]*(o[1]-a[1]) + n[2]*(o[2]-a[2]);
+        if (!(fabsf(h) > 1e-6f*nn*sqrtf(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]))) return 1;
+
+        // Flip the winding if the normal points toward the opposite corner
+        const float* q[3] = {a, (h > 0) ? c : b, (h > 0) ? b : c};
+        float sgn = (h > 0) ? -1.0f : 1.0f;
+        for (int d=0; d<3; d++) {
+            f->n[d] = sgn*n[d]/nn;
+            for (int e=0; e<3; e++) f->p[e][d] = q[e][d];
+        }
+
+        for (int e=0; e<3; e++) {
+            const float* p0 = f->p[e];
+            const float* p1 = f->p[(e+1) % 3];
+            float t[3] = {p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2]};
+            f->len[e] = sqrtf(t[0]*t[0] + t[1]*t[1] + t[2]*t[2]);
+            for (int d=0; d<3; d++) f->s[e][d] = t[d]/f->len[e];
+
+            // m = s x n
+            f->m[e][0] = f->s[e][1]*f->n[2] - f->s[e][2]*f->n[1];
+            f->m[e][1] = f->s[e][2]*f->n[0] - f->s[e][0]*f->n[2];
+            f->m[e][2] = f->s[e][0]*f->n[1] - f->s[e][1]*f->n[0];
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+    face_potential(f, x, y, z)
+
+Integral of 1/|r - r'| over the face, for the observation point r = (x,y,z).
+
+Reference:
+"Potential Integrals for Uniform and Linear Source Distributions on Polygonal
+and Polyhedral Domains", Wilton, Rao, Glisson, Schaubert, Al-Bundak, Butler
+(1984), IEEE Trans. Antennas Propag. 32(3)
+*/
+static inline float face_potential(const Face* f, float x, float y, float z) {
+
+    // Signed height of the point above the face plane
+    float d = f->n[0]*(x - f->p[0][0]) + f->n[1]*(y - f->p[0][1]) + f->n[2]*(z - f->p[0][2]);
+    float ad = fabsf(d);
+    float lnsum = 0;
+    float atsum = 0;
+
+    for (int e=0; e<3; e++) {
+        const float* p0 = f->p[e];
+        const float* p1 = f->p[(e+1) % 3];
+        float v0[3] = {p0[0]-x, p0[1]-y, p0[2]-z};
+        float v1[3] = {p1[0]-x, p1[1]-y, p1[2]-z};
+
+        // Position along the edge of its end points, and distance of the
+        //  projected point from the edge line (positive on the inner side)
+        float sm = v0[0]*f->s[e][0] + v0[1]*f->s[e][1] + v0[2]*f->s[e][2];
+        float sp = sm + f->len[e];
+        float t0 = v0[0]*f->m[e][0] + v0[1]*f->m[e][1] + v0[2]*f->m[e][2];
+        float R02 = t0*t0 + d*d;
+        float Rm = sqrtf(v0[0]*v0[0] + v0[1]*v0[1] + v0[2]*v0[2]);
+        float Rp = sqrtf(v1[0]*v1[0] + v1[1]*v1[1] + v1[2]*v1[2]);
+
+        // Both terms vanish on the edge line itself
+        if (!(R02 > 1e-20f*f->len[e]*f->len[e])) continue;
+
+        // R + s, using (R+s)(R-s) = R0^2 to avoid cancellation when s < 0
+        float Ap = (sp > 0) ? Rp + sp : R02/(Rp - sp);
+        float Am = (sm > 0) ? Rm + sm : R02/(Rm - sm);
+        lnsum += t0*logf(Ap/Am);
+        atsum += atan2f(t0*sp, R02 + ad*Rp) - atan2f(t0*sm, R02 + ad*Rm);
+    }
+
+    return lnsum - ad*atsum;
+}
+
+
+/*
+    bfield_tets(Bx, By, Bz, x, y, z, tets, Nn, Ne, mu_r)
+
+Calculate the Bfield contributions of a series of Tet elements at a sequence of
+node points (x,y,z), adding them to (Bx, By, Bz).
+
+With uniform current density J, B = mu0/4pi J x g, where g is the integral of
+(r - r')/|r - r'|^3 over the element. By the divergence theorem g is the sum
+over the faces of n * (integral of 1/|r - r'| over the face), which has a
+closed form.
+*/
+int bfield_tets(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const Tet* tets, int Nn, int Ne, float mu_r)
+{
+    Face faces[4];
+
+    // exit if any of the inputs don't exist
+    if (!(x && y && z && tets)) {
+        printf("error!\n");
+        return 1;
+    }
+
+    for (int i=0; i<Ne; i++) {
+
+        if (tet_faces(faces, &tets[i])) continue;
+
+        // d = mu_r * mu0 / (4pi)
+        float d = mu_r * (1e-7f);
+        const float* J = tets[i].J;
+
+        for (int j=0; j<Nn; j++) {
+            float g[3] = {0};
+            for (int k=0; k<4; k++) {
+                float phi = face_potential(&faces[k], x[j], y[j], z[j]);
+                g[0] += phi*faces[k].n[0];
+                g[1] += phi*faces[k].n[1];
+                g[2] += phi*faces[k].n[2];
+            }
+
+            // B += d * (J x g)
+            Bx[j] += d*(J[1]*g[2] - J[2]*g[1]);
+            By[j] += d*(J[2]*g[0] - J[0]*g[2]);
+            Bz[j] += d*(J[0]*g[1] - J[1]*g[0]);
+        }
+    }
+
+    return 0;
+}
+
+
+// Sources of a natively parallel evaluation of tetrahedra
+typedef struct {
+    const Tet* tets;
+    int Ne;
+    float mu_r;
+} TetsTile;
+
+// Field of one partition of nodes (see parallel.h)
+static int tets_tile(float* Bx, float* By, float* Bz, const float* x, const float* y, const float* z, 
+                     int n, int* count, const void* ctx)
+{
+    const TetsTile* c = ctx;
+    for (int j=0; j<n; j++) {
+        Bx[j] = 0;
+        By[j] = 0;
+        Bz[j] = 0;
+    }
+    return bfield_tets(Bx, By, Bz, x, y, z, c->tets, n, c->Ne, c->mu_r);
+}
+
+
+/*
+    bfield_tets_parallel(...)
+
+Native (OpenMP) parallel mode, as in `bfield_wires_parallel`: nodes are
+partitioned across threads, and the output arrays are overwritten.
+*/
+int bfield_tets_parallel(float* Bx, float* By, float* Bz,
+                const float* x, const float* y, const float* z,
+                const Tet* tets, int Nn, int Ne, float mu_r,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    TetsTile ctx = {tets, Ne, mu_r};
+    return field_parallel(Bx, By, Bz, x, y, z, Nn, NULL, tets_tile, &ctx, opts, cpus, stats);
+}
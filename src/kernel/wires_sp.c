@@ -6,12 +6,21 @@
     - Threads are managed by Julia
 */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <time.h>
 
+#define REAL float
+#include "parallel.h"
+#include "celllist.h"
+#include "grid.h"
+#include "singular.h"
+#include "reduce.h"
+#include "morton.h"
+
 
 // Testing @ccall from Julia
 void test(float* a, float* b) {
@@ -28,7 +37,7 @@ typedef struct {
 
 
 static inline float mag3(float x, float y, float z){
-    return pow(x*x + y*y + z*z, 0.5);
+    return sqrtf(x*x + y*y + z*z);
 }
 
 static inline float dot3(float a1, float a2, float a3, float b1, float b2, float b3) {
@@ -40,47 +49,146 @@ static inline float dot3(float a1, float a2, float a3, float b1, float b2, float
     return result;
 }
 
-int bfield_wires(float* _Bx, float* _By, float* _Bz, const float* x, const float* y, const float* z, 
-           const Wire* wires, int Nn, int Nw, float mu_r, int check_inside)
+/*
+    inside_wires(pairs, x, y, z, wires, Nn, Nw)
+
+Find the node/wire pairs where the node lies inside the conductor (within the 
+wire radius R of its axis, between its end points) using a cell list over the 
+nodes, and store the current density correction factor jc = (r/R)^2 for each. 
+Only the cells near each wire are visited, so this costs ~O(Nn + Nw) for 
+meshes of short wires rather than O(Nn*Nw). Returns nonzero, with the 
+list freed, if it runs out of memory.
+*/
+static int inside_wires(PairList* pairs, const float* x, const float* y, const float* z, 
+                        const Wire* wires, int Nn, int Nw)
+{
+    CellList cl;
+    if (pairlist_init(pairs, Nw) || celllist_build(&cl, x, y, z, Nn)) {
+        pairlist_free(pairs);
+        return 1;
+    }
+    int nomem = 0;
+    double halfdiag = 0.8660254037844386 * cl.h;
+
+    for (int i=0; i<Nw; i++) {
+        const float* a0 = wires[i].a0;
+        double R = wires[i].R;
+        double a[3], lo[3], hi[3];
+        int c0[3], c1[3];
+
+        for (int d=0; d<3; d++) {
+            a[d] = wires[i].a1[d] - a0[d];
+            lo[d] = fmin(a0[d], wires[i].a1[d]) - R;
+            hi[d] = fmax(a0[d], wires[i].a1[d]) + R;
+        }
+        double a2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+
+        if (R > 0 && a2 > 0 && celllist_range(&cl, lo, hi, c0, c1)) {
+            for (int k2=c0[2]; k2<=c1[2]; k2++) {
+            for (int k1=c0[1]; k1<=c1[1]; k1++) {
+            for (int k0=c0[0]; k0<=c1[0]; k0++) {
+
+                // Skip cells that cannot touch the conductor
+                double p[3] = {cl.lo[0] + (k0 + 0.5)*cl.h - a0[0], 
+                                cl.lo[1] + (k1 + 0.5)*cl.h - a0[1], 
+                                cl.lo[2] + (k2 + 0.5)*cl.h - a0[2]};
+                double t = fmin(fmax((p[0]*a[0] + p[1]*a[1] + p[2]*a[2]) / a2, 0.0), 1.0);
+                double dist = mag3(p[0] - t*a[0], p[1] - t*a[1], p[2] - t*a[2]);
+                if (dist > R + halfdiag) continue;
+
+                int c = (k2*cl.n[1] + k1)*cl.n[0] + k0;
+                for (int k=cl.start[c]; k<cl.start[c+1]; k++) {
+                    int j = cl.idx[k];
+
+                    // p points from the start of the wire to the node 
+                    p[0] = x[j] - a0[0];
+                    p[1] = y[j] - a0[1];
+                    p[2] = z[j] - a0[2];
+                    double pa = p[0]*a[0] + p[1]*a[1] + p[2]*a[2];
+                    if (pa < 0 || pa > a2) continue;
+
+                    // |p x a|^2/a2 rather than |p|^2 - (p.a)^2/a2, which cancels near the 
+                    //  axis and would leave the correction far too weak there
+                    double px = p[1]*a[2] - p[2]*a[1];
+                    double py = p[2]*a[0] - p[0]*a[2];
+                    double pz = p[0]*a[1] - p[1]*a[0];
+                    double r2 = (px*px + py*py + pz*pz)/a2;
+                    if (r2 < R*R) nomem |= pairlist_push(pairs, j, r2/(R*R));
+                }
+            }
+            }
+            }
+        }
+
+        pairs->ptr[i+1] = pairs->n;
+    }
+
+    celllist_free(&cl);
+    if (nomem) pairlist_free(pairs);
+    return nomem;
+}
+
+// Scratch space needed by wires_kernel: 11 arrays of Nn values, each padded 
+//  to a multiple of 16 values to keep them 64-byte aligned
+#define WORK_LD(Nn) ((((size_t)(Nn) + 15)/16)*16)
+#define WORK_SIZE(Nn) (11*WORK_LD(Nn)*sizeof(float))
+
+// Calculate the Bfield contributions of a series of Wire objects at a sequence
+//   of node points (x,y,z), using caller-provided scratch space of WORK_SIZE(Nn).
+//   If I is given (Nw x M), the wire currents are replaced by M sets of currents 
+//   and M fields are accumulated in (Bx, By, Bz), each Nn long, from one pass 
+//   over the geometry. Singular pairs are treated according to `policy`, and 
+//   counted per node in nsing if given (see singular.h)
+static int wires_kernel(float* _Bx, float* _By, float* _Bz, const float* x, const float* y, const float* z, 
+           const Wire* wires, int Nn, int Nw, float mu_r, int check_inside, 
+           int policy, int* nsing, const float* I, int M, float* work)
 {
 
     float d; 
-    float mag;
-    float ac;
-    float ab;
-    float ac_ab;
+    float a2;
     float a[3] = {0};
-    float* cx = aligned_alloc(32, 32*Nn);
-    float* cy = aligned_alloc(32, 32*Nn);
-    float* cz = aligned_alloc(32, 32*Nn);
-    float* bx = aligned_alloc(32, 32*Nn);
-    float* by = aligned_alloc(32, 32*Nn);
-    float* bz = aligned_alloc(32, 32*Nn);
-    float* Bx = aligned_alloc(32, 32*Nn);
-    float* By = aligned_alloc(32, 32*Nn);
-    float* Bz = aligned_alloc(32, 32*Nn);
-    float* g = aligned_alloc(32, 32*Nn);
-    float* jc = NULL;
-    float* r = NULL;
-    if (check_inside > 0) {
-        // Only allocate if we have to
-        jc = aligned_alloc(32, 32*Nn);
-        r = aligned_alloc(32, 32*Nn);
+    float tol2 = singular_tol2(policy);
+    size_t ld = WORK_LD(Nn);
+    float* cx = work + 0*ld;
+    float* cy = work + 1*ld;
+    float* cz = work + 2*ld;
+    float* bx = work + 3*ld;
+    float* by = work + 4*ld;
+    float* bz = work + 5*ld;
+    float* Bx = work + 6*ld;
+    float* By = work + 7*ld;
+    float* Bz = work + 8*ld;
+    float* g = work + 9*ld;
+    float* sing = work + 10*ld;
+    PairList pairs = {0};
+
+    // exit if any of the inputs (or the scratch space) don't exist
+    if (!(work && x && y && z && wires)) {
+        printf("error!\n");
+        return 1;
     }
 
-    // exit if any of the inputs don't exist
-    if (!(x && y && z && wires)) {
+    // Find the node/wire pairs that need the current density correction up 
+    //  front, so that the loops below stay branch-free for every other pair
+    if (check_inside > 0 && inside_wires(&pairs, x, y, z, wires, Nn, Nw)) {
+        printf("error!\n");
+        return 1;
+    }
+    int* count = singular_counts(nsing, policy, Nn);
+    if (singular_nomem(count, policy)) {
         printf("error!\n");
+        pairlist_free(&pairs);
         return 1;
     }
 
     // Outer loop over sources (wires)
     for (int i=0; i<Nw; i++) {
 
-        d = mu_r * (1e-7) * wires[i].I;
+        d = mu_r * (1e-7) * (I ? 1 : wires[i].I);
         a[0] = wires[i].a1[0] - wires[i].a0[0];
         a[1] = wires[i].a1[1] - wires[i].a0[1];
         a[2] = wires[i].a1[2] - wires[i].a0[2]; 
+        a2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
 
         // Calculate the b and c vectors, which point from the node 
         //  to the start and end of the Wire
@@ -105,76 +213,682 @@ int bfield_wires(float* _Bx, float* _By, float* _Bz, const float* x, const float
             Bz[j] = cx[j]*a[1] - cy[j]*a[0];    //   cx*ay  -  cy*ax
         }
 
-        // At the same time, calculate the distance from the center of the 
-        //  conductor to the node and determine correction factor, but only if
-        //  requested.
-        // r = |c x a| / |a|
-        if (check_inside > 0) {
-            mag = 1/mag3(a[0], a[1], a[2]);               // |a|
-            for (int j=0; j<Nn; j++) {
-                r[j] = mag*mag3(Bx[j], By[j], Bz[j]);     // |c x a| 
-            }
-
-            mag = 1/(wires[i].R * wires[i].R);
-            for (int j=0; j<Nn; j++) {
-                jc[j] = mag*(r[j]*r[j]);
-            } 
-        }
- 
-        // Divide B by the magnitude squared and include constant d
-        // B = cxa --> B = d*cxa/mag(cxa)^2
-        // mag = sqrt(Bx^2 + By^2 + Bz^2)
-        // mag^2 = Bx^2 + By^2 + Bz^2
+        // Scale B = cxa by g = d (a.c/|c| - a.b/|b|)/|cxa|^2
+        // Beyond either end (a.c a.b > 0) the difference cancels, so the stable form
+        //  g = d (a.c + a.b)/(|c| |b| (a.c |b| + a.b |c|)) is used unless the policy 
+        //  is SINGULAR_ZERO; on the axis there it gives the exact field, zero. Pairs 
+        //  with the node on the axis between the ends, or at an end, are singular 
+        //  (sing = 1, g = 0)
+        int stable = (policy != SINGULAR_ZERO);
         for (int j=0; j<Nn; j++) {
-            // TODO: check if divide by zero
-            // assert((pow(Bx[j], 2) + pow(By[j], 2) + pow(Bz[j], 2)) > 1e-8);
-            float denom = ((Bx[j]*Bx[j]) + (By[j]*By[j]) +(Bz[j]*Bz[j]) );
-            g[j] = d/denom;
+            float denom = ((Bx[j]*Bx[j]) + (By[j]*By[j]) +(Bz[j]*Bz[j]));
+            float ac = dot3(a[0], a[1], a[2], cx[j], cy[j], cz[j]);
+            float ab = dot3(a[0], a[1], a[2], bx[j], by[j], bz[j]);
+            float nc = mag3(cx[j], cy[j], cz[j]);
+            float nb = mag3(bx[j], by[j], bz[j]);
+            int beyond = stable & (ac*ab > 0);
+            int s = (!beyond) & ((!(denom > tol2*a2*nc*nc)) | (!(nc*nb > 0)));
+            float gout = (ac + ab) / (beyond ? nc*nb*(ac*nb + ab*nc) : 1);
+            float gin = (ac/(s ? 1 : nc) - ab/(s ? 1 : nb)) / (s ? 1 : denom);
+            g[j] = beyond ? d*gout : (s ? 0 : d*gin);
+            sing[j] = s;
         }
         for (int j=0; j<Nn; j++) {     
             Bx[j] *= g[j];
             By[j] *= g[j]; 
             Bz[j] *= g[j];    
         }
+        singular_add(count, sing, Nn);
 
-        // Apply correction factor if requested
+        // Apply the current density correction to the nodes inside the conductor
         if (check_inside > 0) {
+            for (int k=pairs.ptr[i]; k<pairs.ptr[i+1]; k++) {
+                int j = pairs.idx[k];
+                float jc = pairs.jc[k];
+                Bx[j] = (jc > 0) ? jc*Bx[j] : 0;
+                By[j] = (jc > 0) ? jc*By[j] : 0;
+                Bz[j] = (jc > 0) ? jc*Bz[j] : 0;
+            }
+        }
+
+        // copy to output array 
+        if (!I) {
             for (int j=0; j<Nn; j++) {
-                jc[j] = (r[j] < wires[i].R) ? ((r[j] > 0) ? jc[j] : 0.0) : 1.0;
+                _Bx[j] += Bx[j];
+                _By[j] += By[j];
+                _Bz[j] += Bz[j];
             }
+            continue;
+        }
+
+        // or scale the field per unit current by each set of currents
+        for (int m=0; m<M; m++) {
+            float Im = I[i + (size_t)m*Nw];
+            float* _Bxm = _Bx + (size_t)m*Nn;
+            float* _Bym = _By + (size_t)m*Nn;
+            float* _Bzm = _Bz + (size_t)m*Nn;
             for (int j=0; j<Nn; j++) {
-                Bx[j] *= jc[j];
-                By[j] *= jc[j];  
-                Bz[j] *= jc[j];    
+                _Bxm[j] += Im*Bx[j];
+                _Bym[j] += Im*By[j];
+                _Bzm[j] += Im*Bz[j];
             }
-        } 
-        
-        // Calculate the dot products and store in B 
-        // B *= (a*c/mag(c) - a*b/mag(b))
-        for (int j=0; j<Nn; j++) {
-            // TODO: check if divide by zero
-            ac_ab = dot3(a[0], a[1], a[2], cx[j], cy[j], cz[j]) / mag3(cx[j], cy[j], cz[j]);
-            ac_ab -= dot3(a[0], a[1], a[2], bx[j], by[j], bz[j]) / mag3(bx[j], by[j], bz[j]);
-            Bx[j] *= ac_ab;
-            By[j] *= ac_ab;
-            Bz[j] *= ac_ab;
         }
+    }
 
-        // copy to output array 
-        for (int j=0; j<Nn; j++) {
-            _Bx[j] += Bx[j];
-            _By[j] += By[j];
-            _Bz[j] += Bz[j];
-        }  
+    if (check_inside > 0) pairlist_free(&pairs);
+    singular_finish(_Bx, _By, _Bz, count, nsing, policy, Nn, I ? M : 1);
+
+    return 0;
+} 
+
+
+// Calculate the Bfield generated a sequence of node points (x,y,z) by a series
+//   of Wire objects; singular pairs are treated according to `policy` and counted 
+//   per node in nsing if given (see singular.h)
+int bfield_wires(float* _Bx, float* _By, float* _Bz, const float* x, const float* y, const float* z, 
+           const Wire* wires, int Nn, int Nw, float mu_r, int check_inside, 
+           int policy, int* nsing)
+{
+    float* work = aligned_alloc(64, WORK_SIZE(Nn) + 64);
+    int status = wires_kernel(_Bx, _By, _Bz, x, y, z, wires, Nn, Nw, mu_r, check_inside, policy, nsing, NULL, 1, work);
+    free(work);
+
+    return status;
+} 
+
+
+
+/*
+    bfield_wires_multi(Bx, By, Bz, x, y, z, wires, I, Nn, Nw, M, mu_r, check_inside, policy, nsing)
+
+Field of the same wires driven by M sets of currents (e.g. the real and imaginary 
+parts of phasors, several harmonics or phases). I is Nw x M (column-major) and 
+replaces wires[i].I. The geometric factor of each node/wire pair is computed once 
+and scaled by every current, so the cost grows with M only in the accumulation. 
+Bx, By and Bz are Nn x M (column-major), and are accumulated.
+*/
+int bfield_wires_multi(float* Bx, float* By, float* Bz, 
+                const float* x, const float* y, const float* z, 
+                const Wire* wires, const float* I, int Nn, int Nw, int M, 
+                float mu_r, int check_inside, int policy, int* nsing)
+{
+    float* work = aligned_alloc(64, WORK_SIZE(Nn) + 64);
+    int status = wires_kernel(Bx, By, Bz, x, y, z, wires, Nn, Nw, mu_r, check_inside, policy, nsing, I, M, work);
+    free(work);
+
+    return status;
+}
+
+/*
+    kernel_reproducible()
+
+1 if the kernel was built for reproducible results (make -B REPRO=1: strict IEEE 
+arithmetic without FMA contraction), 0 for the default fast-math build.
+*/
+int kernel_reproducible(void)
+{
+#ifdef WIRED_REPRO
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*
+    morton_sort(perm, x, y, z, N, Nt)
+
+Permutation (0-based) that sorts N points (x,y,z) along a Morton curve, from a 
+parallel radix sort over Nt threads (see morton.h). Used to reorder nodes and 
+sources so that neighbours in memory are neighbours in space.
+*/
+int morton_sort(int* perm, const float* x, const float* y, const float* z, int N, int Nt)
+{
+    return morton_order(perm, x, y, z, N, Nt);
+}
+
+
+// Sources and options of a reduction over the field of wires
+typedef struct {
+    const Wire* wires;
+    int Nw;
+    float mu_r;
+    int check_inside;
+    int policy;
+} WiresTile;
+
+// Field of one tile of nodes (see reduce.h)
+static int wires_tile(float* Bx, float* By, float* Bz, const float* x, const float* y, const float* z, 
+                      int n, int* count, const void* ctx)
+{
+    const WiresTile* c = ctx;
+    for (int j=0; j<n; j++) {
+        Bx[j] = 0;
+        By[j] = 0;
+        Bz[j] = 0;
+    }
+    return bfield_wires(Bx, By, Bz, x, y, z, c->wires, n, c->Nw, c->mu_r, c->check_inside, 
+                        c->policy, count);
+}
+
+/*
+    bfield_wires_reduce(out, x, y, z, w, nx, ny, nz, wires, Nn, Nw, mu_r, check_inside, policy, tile, Nt)
+
+Reduce the field of the wires at Nn nodes to the scalars of a Reduction (sums 
+weighted by w, flux through the normals (nx, ny, nz), and the extremes of |B|) 
+without storing it: tiles of `tile` nodes are evaluated on Nt OpenMP threads 
+and folded as they finish (see reduce.h). w and the normals are double in both 
+precisions, like the sums they go into, and may be NULL.
+*/
+int bfield_wires_reduce(Reduction* out, const float* x, const float* y, const float* z, 
+                const double* w, const double* nx, const double* ny, const double* nz, 
+                const Wire* wires, int Nn, int Nw, float mu_r, int check_inside, 
+                int policy, int tile, int Nt)
+{
+    WiresTile ctx = {wires, Nw, mu_r, check_inside, policy};
+    return reduce_tiles(out, wires_tile, &ctx, x, y, z, w, nx, ny, nz, Nn, tile, policy, Nt);
+}
+
+
+/*
+    bfield_wires_parallel(...)
+
+Native (OpenMP) parallel mode: nodes are partitioned across threads and each 
+thread runs `bfield_wires` over every wire for its own partition (see 
+`field_parallel` in parallel.h). The output arrays are overwritten, and 
+per-thread placement and timing are reported in `stats`, which must hold at 
+least opts->Nt entries.
+*/
+int bfield_wires_parallel(float* Bx, float* By, float* Bz, 
+                const float* x, const float* y, const float* z, 
+                const Wire* wires, int Nn, int Nw, float mu_r, int check_inside,
+                int policy, int* nsing,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    WiresTile ctx = {wires, Nw, mu_r, check_inside, policy};
+    return field_parallel(Bx, By, Bz, x, y, z, Nn, nsing, wires_tile, &ctx, opts, cpus, stats);
+}
+
+
+// Match the Problem definition in Julia: one independent Biot-Savart problem, 
+//  given as offsets into buffers shared by the whole batch
+typedef struct {
+    int wire0;          // first wire of the problem (0-based)
+    int Nw;             // number of wires
+    int node0;          // first node of the problem (0-based)
+    int Nn;             // number of nodes
+    int out0;           // first output entry of the problem (0-based)
+} Problem;
+
+/*
+    bfield_wires_batch(...)
+
+Solve Np small, independent problems in one call. Each problem reads its 
+wires and nodes from (and writes its output to) slices of the shared buffers, 
+so problems may share a node set as long as their output slices differ. The 
+output slices are overwritten.
+
+Problems are handed out to the OpenMP threads one at a time as each thread 
+finishes its last one (dynamic scheduling), which keeps all cores busy even 
+when problem sizes differ. Each thread reuses one scratch buffer sized for the 
+largest problem; if a thread cannot allocate it, its problems are left 
+zeroed and the call returns nonzero.
+*/
+int bfield_wires_batch(float* Bx, float* By, float* Bz, 
+                const float* x, const float* y, const float* z, 
+                const Wire* wires, const Problem* problems, int Np, 
+                float mu_r, int check_inside, int policy, int* nsing, int Nt)
+{
+    int status = 0;
+    int Nmax = 0;
+    for (int p=0; p<Np; p++) {
+        if (problems[p].Nn > Nmax) Nmax = problems[p].Nn;
+    }
+
+    #pragma omp parallel num_threads(Nt) reduction(|:status)
+    {
+        float* work = aligned_alloc(64, WORK_SIZE(Nmax) + 64);
+        if (!work) status |= 1;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int p=0; p<Np; p++) {
+            const Problem* q = &problems[p];
+            for (int j=q->out0; j<q->out0 + q->Nn; j++) {
+                Bx[j] = 0;
+                By[j] = 0;
+                Bz[j] = 0;
+            }
+            if (!work) continue;
+            status |= wires_kernel(Bx + q->out0, By + q->out0, Bz + q->out0, 
+                                   x + q->node0, y + q->node0, z + q->node0, 
+                                   wires + q->wire0, q->Nn, q->Nw, mu_r, check_inside, policy, 
+                                   nsing ? nsing + q->out0 : NULL, NULL, 1, work);
+        }
+
+        free(work);
+    }
+
+    return status;
+}
+
+
+/*
+    wires_grid_rows(Bx, By, Bz, grid, wires, Nw, mu_r, check_inside, policy, count, r0, r1)
+
+Add the field of a series of Wire objects at rows r0 ... r1-1 of a Grid (row 
+r = j + n[1]*k holds the n[0] nodes (0...n[0]-1, j, k)); Bx, By, Bz hold the 
+whole grid. The singular pairs of each node are added to count (count[0] is the 
+first node of row r0), if not NULL.
+
+No node coordinates are formed. With a = a1 - a0 and c = a1 - x, both c x a and 
+a.c are affine in the grid indices: they are set up once per wire and row, and 
+along the row each node only needs one multiply-add per component. |c| and 
+|b| = |c - a| follow from |c|^2 |a|^2 = (a.c)^2 + |c x a|^2.
+
+Singular pairs are treated as in `wires_kernel` (see singular.h), except that a 
+node is on the axis when it is within the roundoff of the affine sums, which do 
+not cancel exactly, for every policy.
+*/
+static void wires_grid_rows(float* restrict Bx, float* restrict By, float* restrict Bz, 
+                const Grid* grid, const Wire* wires, int Nw, float mu_r, int check_inside, 
+                int policy, int* restrict count, int r0, int r1)
+{
+    int n0 = grid->n[0];
+    int n1 = grid->n[1];
+    int block = grid_rows_per_block(n0);
+    int stable = (policy != SINGULAR_ZERO);
+    size_t base = (size_t)r0*n0;
+
+    for (int rb=r0; rb<r1; rb+=block) {
+        int re = (rb + block < r1) ? rb + block : r1;
+
+        for (int w=0; w<Nw; w++) {
+            const Wire* wire = &wires[w];
+            float a[3] = {wire->a1[0] - wire->a0[0], 
+                           wire->a1[1] - wire->a0[1], 
+                           wire->a1[2] - wire->a0[2]};
+            float a2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+            if (!(a2 > 0)) continue;
+            float sa = sqrt(a2);
+            float d = mu_r * (1e-7) * wire->I;
+            float Ra2 = (check_inside > 0) ? wire->R*wire->R*a2 : 0;
+
+            // c x a and a.c at the first node, and their steps along each axis
+            float c[3] = {wire->a1[0] - grid->o[0], 
+                           wire->a1[1] - grid->o[1], 
+                           wire->a1[2] - grid->o[2]};
+            float p[4] = {c[1]*a[2] - c[2]*a[1], 
+                           c[2]*a[0] - c[0]*a[2], 
+                           c[0]*a[1] - c[1]*a[0], 
+                           c[0]*a[0] + c[1]*a[1] + c[2]*a[2]};
+            float q[3][4];
+            for (int m=0; m<3; m++) {
+                const float* e = grid->e[m];
+                q[m][0] = e[1]*a[2] - e[2]*a[1];
+                q[m][1] = e[2]*a[0] - e[0]*a[2];
+                q[m][2] = e[0]*a[1] - e[1]*a[0];
+                q[m][3] = e[0]*a[0] + e[1]*a[1] + e[2]*a[2];
+            }
+
+            for (int r=rb; r<re; r++) {
+                int j = r % n1;
+                int k = r / n1;
+                float px = p[0] - j*q[1][0] - k*q[2][0];
+                float py = p[1] - j*q[1][1] - k*q[2][1];
+                float pz = p[2] - j*q[1][2] - k*q[2][2];
+                float ps = p[3] - j*q[1][3] - k*q[2][3];
+                size_t o = (size_t)r * n0;
+
+                for (int i=0; i<n0; i++) {
+                    float cx = px - i*q[0][0];
+                    float cy = py - i*q[0][1];
+                    float cz = pz - i*q[0][2];
+                    float s = ps - i*q[0][3];      // a.c
+                    float sb = s - a2;             // a.b
+                    float rho2 = cx*cx + cy*cy + cz*cz;
+                    float qc = sqrtf(s*s + rho2);      // |a| |c|
+                    float qb = sqrtf(sb*sb + rho2);    // |a| |b|
+
+                    // On the axis beyond the ends, a.c/|c| - a.b/|b| cancels: 
+                    //  use the stable form (s + sb) rho2/(|c| |b| (s |b| + sb |c|)) 
+                    //  instead, as in wires_kernel. Singular pairs (on the wire axis 
+                    //  or an end point, to within the roundoff of the affine sums) 
+                    //  add zero; (r/R)^2 inside the conductor
+                    int axis = !(rho2 > 1e-10f*(s*s + a2*a2));
+                    int end = (!(s*s + rho2 > 1e-10f*a2*a2)) | (!(sb*sb + rho2 > 1e-10f*a2*a2));
+                    int beyond = stable & (s*sb > 0) & (!end);
+                    int sing = end | ((!beyond) & axis);
+                    float num = beyond ? (s + sb)*a2 : s*qb - sb*qc;
+                    float den = sing ? 1 : qc*qb*(beyond ? s*qb + sb*qc : rho2);
+                    float g = sing ? 0 : d*sa*num/den;
+                    int inside = (s >= 0) & (s <= a2) & (rho2 < Ra2);
+                    g = inside ? g*rho2/Ra2 : g;
+                    if (count) count[o - base + i] += sing;
+
+                    Bx[o+i] += g*cx;
+                    By[o+i] += g*cy;
+                    Bz[o+i] += g*cz;
+                }
+            }
+        }
     }
+}
+
 
-    free(bx); free(by); free(bz); free(cx); free(cy); free(cz); free(g);
+/*
+    bfield_wires_grid(Bx, By, Bz, grid, wires, Nw, mu_r, check_inside, policy, nsing)
 
-    if (jc) free(jc);
-    if (r) free(r);
+Calculate the Bfield generated by a series of Wire objects at every node of a 
+Grid, adding it to (Bx, By, Bz) (n[0]*n[1]*n[2] values each). Singular pairs are 
+treated according to `policy` and counted in nsing, as in `bfield_wires`.
+*/
+int bfield_wires_grid(float* Bx, float* By, float* Bz, const Grid* grid, 
+                const Wire* wires, int Nw, float mu_r, int check_inside, int policy, int* nsing)
+{
+    // exit if any of the inputs don't exist
+    if (!(grid && wires)) {
+        printf("error!\n");
+        return 1;
+    }
 
+    int Nn = grid->n[0]*grid->n[1]*grid->n[2];
+    int* count = singular_counts(nsing, policy, Nn);
+    if (singular_nomem(count, policy)) {
+        printf("error!\n");
+        return 1;
+    }
+    wires_grid_rows(Bx, By, Bz, grid, wires, Nw, mu_r, check_inside, policy, count, 0, grid->n[1]*grid->n[2]);
+    singular_finish(Bx, By, Bz, count, nsing, policy, Nn, 1);
     return 0;
-} 
+}
+
+
+// Arrays, grid and sources of a natively parallel Grid evaluation
+typedef struct {
+    float* Bx;
+    float* By;
+    float* Bz;
+    const Grid* grid;
+    const Wire* wires;
+    int Nw;
+    float mu_r;
+    int check_inside;
+    int policy;
+    int* nsing;
+} WiresGridWork;
+
+// Field of grid rows r0 ... r1-1 (overwritten); each thread first touches its own rows
+static int wires_grid_partition(int r0, int r1, const ParallelOptions* opts, const void* ctx)
+{
+    const WiresGridWork* c = ctx;
+    int n0 = c->grid->n[0];
+    for (size_t j=(size_t)r0*n0; j<(size_t)r1*n0; j++) {
+        c->Bx[j] = 0;
+        c->By[j] = 0;
+        c->Bz[j] = 0;
+    }
+
+    // Counts of this partition alone (see singular.h)
+    size_t off = (size_t)r0*n0;
+    int n = (r1 - r0)*n0;
+    int* nsing = c->nsing ? c->nsing + off : NULL;
+    int* count = singular_counts(nsing, c->policy, n);
+    if (singular_nomem(count, c->policy)) return 1;
+    wires_grid_rows(c->Bx, c->By, c->Bz, c->grid, c->wires, c->Nw, c->mu_r, c->check_inside, 
+                    c->policy, count, r0, r1);
+    singular_finish(c->Bx + off, c->By + off, c->Bz + off, count, nsing, c->policy, n, 1);
+    return 0;
+}
+
+
+/*
+    bfield_wires_grid_parallel(...)
+
+Native (OpenMP) parallel mode for Grid targets: grid rows are partitioned 
+across threads as in `bfield_wires_parallel`, and the output arrays are 
+overwritten. Each thread first touches its own output rows; the node ranges 
+in `stats` are in grid nodes. Singular pairs are treated according to `policy` 
+and counted in nsing (one entry per grid node, or NULL).
+*/
+int bfield_wires_grid_parallel(float* Bx, float* By, float* Bz, const Grid* grid, 
+                const Wire* wires, int Nw, float mu_r, int check_inside, int policy, int* nsing,
+                const ParallelOptions* opts, const int* cpus, ThreadStats* stats)
+{
+    // exit if any of the inputs don't exist
+    if (!(grid && wires)) {
+        printf("error!\n");
+        return 1;
+    }
+
+    WiresGridWork work = {Bx, By, Bz, grid, wires, Nw, mu_r, check_inside, policy, nsing};
+    run_partitions(wires_grid_partition, &work, grid->n[1]*grid->n[2], opts, cpus, stats);
+
+    // Report the node ranges in grid nodes
+    for (int t=0; t<opts->Nt; t++) {
+        stats[t].n0 *= grid->n[0];
+        stats[t].n1 *= grid->n[0];
+    }
+
+    return 0;
+}
+
+
+/*
+    wire_pair_jacobian(w, x, y, z, mu_r, inside, B, J)
+
+Field of one wire at one node, B = d*f*q*u, and its derivatives with respect to 
+the wire parameters p = (a0x, a0y, a0z, a1x, a1y, a1z, I), J[m][k] = dB[m]/dp[k]. 
+Here 
+    u = c x a,   f = a.c/|c| - a.b/|b|,   d = mu_r*mu0*I/(4pi), 
+and q = 1/|u|^2 outside the conductor, or q = 1/(R^2 |a|^2) inside it (which is 
+the current density correction applied to 1/|u|^2). 
+
+Returns 0 for singular pairs (node on the wire axis outside the conductor, or 
+on an end point), which contribute nothing; B and J are left untouched.
+*/
+static inline int wire_pair_jacobian(const Wire* w, double x, double y, double z, 
+                                     double mu_r, int inside, double B[3], double J[3][7])
+{
+    double a[3], b[3], c[3];
+    for (int k=0; k<3; k++) a[k] = w->a1[k] - w->a0[k];
+    b[0] = w->a0[0] - x;    c[0] = w->a1[0] - x;
+    b[1] = w->a0[1] - y;    c[1] = w->a1[1] - y;
+    b[2] = w->a0[2] - z;    c[2] = w->a1[2] - z;
+
+    double u[3] = {c[1]*a[2] - c[2]*a[1], c[2]*a[0] - c[0]*a[2], c[0]*a[1] - c[1]*a[0]};
+    double s = u[0]*u[0] + u[1]*u[1] + u[2]*u[2];
+    double a2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+    double nb = sqrt(b[0]*b[0] + b[1]*b[1] + b[2]*b[2]);
+    double nc = sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+    if ((!inside && !(s > 0)) || !(a2 > 0) || !(nb > 0) || !(nc > 0)) return 0;
+
+    double ab = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    double ac = a[0]*c[0] + a[1]*c[1] + a[2]*c[2];
+    double f = ac/nc - ab/nb;
+    double d0 = mu_r * (1e-7);
+    double d = d0 * w->I;
+    double q = inside ? 1/(w->R * w->R * a2) : 1/s;
+
+    // Gradients of f and q with respect to a0 and a1 
+    double fa0[3], fa1[3], qa0[3], qa1[3];
+    double uxb[3] = {u[1]*b[2] - u[2]*b[1], u[2]*b[0] - u[0]*b[2], u[0]*b[1] - u[1]*b[0]};
+    double cxu[3] = {c[1]*u[2] - c[2]*u[1], c[2]*u[0] - c[0]*u[2], c[0]*u[1] - c[1]*u[0]};
+    for (int k=0; k<3; k++) {
+        fa0[k] = -c[k]/nc + b[k]/nb - a[k]/nb + ab*b[k]/(nb*nb*nb);
+        fa1[k] = c[k]/nc + a[k]/nc - ac*c[k]/(nc*nc*nc) - b[k]/nb;
+        qa0[k] = inside ? 2*q*a[k]/a2 : -2*q*q*cxu[k];
+        qa1[k] = inside ? -2*q*a[k]/a2 : -2*q*q*uxb[k];
+    }
+
+    // Derivatives of u: du/da0[k] = e_k x c,  du/da1[k] = b x e_k
+    double ua0[3][3] = {{0, c[2], -c[1]}, {-c[2], 0, c[0]}, {c[1], -c[0], 0}};
+    double ua1[3][3] = {{0, -b[2], b[1]}, {b[2], 0, -b[0]}, {-b[1], b[0], 0}};
+
+    for (int m=0; m<3; m++) {
+        B[m] = d*f*q*u[m];
+        for (int k=0; k<3; k++) {
+            J[m][k] = d*(fa0[k]*q*u[m] + f*q*ua0[m][k] + f*qa0[k]*u[m]);
+            J[m][3+k] = d*(fa1[k]*q*u[m] + f*q*ua1[m][k] + f*qa1[k]*u[m]);
+        }
+        J[m][6] = d0*f*q*u[m];
+    }
+
+    return 1;
+}
+
+/*
+    mark_inside(inside, pairs, i, value)
+
+Flag (value=1) or unflag (value=0) the nodes inside the conductor of wire i.
+*/
+static inline void mark_inside(char* inside, const PairList* pairs, int i, char value) {
+    for (int k=pairs->ptr[i]; k<pairs->ptr[i+1]; k++) inside[pairs->idx[k]] = value;
+}
+
+/*
+    bfield_wires_vjp(...)
+
+Adjoint (vector-Jacobian product) mode. Given G = dJ/dB at each node for some 
+scalar objective J, calculate B and, in the same pass, the gradient of J with 
+respect to every wire parameter:
+    grad[7*i + k] = sum_j G_j . dB_j/dp_ik,   p_i = (a0x, a0y, a0z, a1x, a1y, a1z, I)
+The cost is O(Nn*Nw), independent of the number of parameters. 
+
+Nodes are partitioned across Nt threads; each thread accumulates the gradient 
+for its own nodes, and the partial gradients are summed in thread order. 
+B is overwritten. Returns nonzero if a thread runs out of memory.
+*/
+int bfield_wires_vjp(float* Bx, float* By, float* Bz, 
+                const float* x, const float* y, const float* z, 
+                const Wire* wires, int Nn, int Nw, float mu_r, int check_inside,
+                const float* Gx, const float* Gy, const float* Gz, float* grad, int Nt)
+{
+    int status = 0;
+    for (long k=0; k<7L*Nw; k++) grad[k] = 0;
+
+    #pragma omp parallel num_threads(Nt) reduction(|:status)
+    {
+        int t = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        int n0 = (int)(((long)Nn * t) / nt);
+        int n = (int)(((long)Nn * (t+1)) / nt) - n0;
+        double* g = calloc(7*(size_t)Nw, sizeof(double));
+        char* inside = calloc(n + 1, 1);
+        PairList pairs = {0};
+        int ok = g && inside;
+        if (ok && check_inside > 0 && n > 0) {
+            ok = !inside_wires(&pairs, x+n0, y+n0, z+n0, wires, n, Nw);
+        }
+        status |= !ok;
+
+        for (int j=n0; j<n0+n; j++) {
+            Bx[j] = 0;
+            By[j] = 0;
+            Bz[j] = 0;
+        }
+
+        for (int i=0; i<Nw && n > 0 && ok; i++) {
+            double Bp[3], Jp[3][7];
+            double gi[7] = {0};
+            if (check_inside > 0) mark_inside(inside, &pairs, i, 1);
+
+            for (int jj=0; jj<n; jj++) {
+                int j = n0 + jj;
+                if (!wire_pair_jacobian(&wires[i], x[j], y[j], z[j], mu_r, inside[jj], Bp, Jp)) continue;
+                Bx[j] += Bp[0];
+                By[j] += Bp[1];
+                Bz[j] += Bp[2];
+                for (int k=0; k<7; k++) {
+                    gi[k] += Gx[j]*Jp[0][k] + Gy[j]*Jp[1][k] + Gz[j]*Jp[2][k];
+                }
+            }
+
+            for (int k=0; k<7; k++) g[7*i + k] += gi[k];
+            if (check_inside > 0) mark_inside(inside, &pairs, i, 0);
+        }
+
+        // Sum the partial gradients in thread order, so results are repeatable
+        #pragma omp for ordered schedule(static, 1)
+        for (int p=0; p<nt; p++) {
+            #pragma omp ordered
+            if (ok) {
+                for (long k=0; k<7L*Nw; k++) grad[k] += g[k];
+            }
+        }
+
+        if (check_inside > 0 && n > 0) pairlist_free(&pairs);
+        free(inside);
+        free(g);
+    }
+
+    return status;
+}
+
+/*
+    bfield_wires_jacobian(...)
+
+Forward sensitivity mode: calculate B and the full Jacobian of B with respect to 
+every wire parameter in the same pass, 
+    J[((j*3 + m)*Nw + i)*7 + k] = dB_j[m]/dp_ik,   p_i = (a0x, a0y, a0z, a1x, a1y, a1z, I)
+J has 21*Nn*Nw entries, so this is only practical for small problems; use 
+bfield_wires_vjp for gradients of a scalar objective. B and J are overwritten. 
+Returns nonzero if a thread runs out of memory.
+*/
+int bfield_wires_jacobian(float* Bx, float* By, float* Bz, 
+                const float* x, const float* y, const float* z, 
+                const Wire* wires, int Nn, int Nw, float mu_r, int check_inside,
+                float* J, int Nt)
+{
+    int status = 0;
+
+    #pragma omp parallel num_threads(Nt) reduction(|:status)
+    {
+        int t = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        int n0 = (int)(((long)Nn * t) / nt);
+        int n = (int)(((long)Nn * (t+1)) / nt) - n0;
+        char* inside = calloc(n + 1, 1);
+        PairList pairs = {0};
+        int ok = (inside != NULL);
+        if (ok && check_inside > 0 && n > 0) {
+            ok = !inside_wires(&pairs, x+n0, y+n0, z+n0, wires, n, Nw);
+        }
+        status |= !ok;
+
+        for (int j=n0; j<n0+n; j++) {
+            Bx[j] = 0;
+            By[j] = 0;
+            Bz[j] = 0;
+        }
+
+        for (int i=0; i<Nw && n > 0 && ok; i++) {
+            double Bp[3], Jp[3][7];
+            if (check_inside > 0) mark_inside(inside, &pairs, i, 1);
+
+            for (int jj=0; jj<n; jj++) {
+                int j = n0 + jj;
+                if (!wire_pair_jacobian(&wires[i], x[j], y[j], z[j], mu_r, inside[jj], Bp, Jp)) {
+                    for (int m=0; m<3; m++) {
+                        for (int k=0; k<7; k++) Jp[m][k] = 0;
+                    }
+                    Bp[0] = 0;  Bp[1] = 0;  Bp[2] = 0;
+                }
+                Bx[j] += Bp[0];
+                By[j] += Bp[1];
+                Bz[j] += Bp[2];
+                for (int m=0; m<3; m++) {
+                    for (int k=0; k<7; k++) J[(((long)j*3 + m)*Nw + i)*7 + k] = Jp[m][k];
+                }
+            }
+
+            if (check_inside > 0) mark_inside(inside, &pairs, i, 0);
+        }
+
+        if (check_inside > 0 && n > 0) pairlist_free(&pairs);
+        free(inside);
+    }
+
+    return status;
+}
 
 #define NUMWIRES 1000
 #define NUMNODES 1000
@@ -216,7 +930,7 @@ int main() {
         }
 
         start = clock();
-        int val = bfield_wires(Bx, By, Bz, x, y, z, wires, Nn, Nw, mu_r, check_inside);
+        int val = bfield_wires(Bx, By, Bz, x, y, z, wires, Nn, Nw, mu_r, check_inside, SINGULAR_ZERO, NULL);
         stop = clock();
 
         totaltime += (float)(stop - start)/CLOCKS_PER_SEC;
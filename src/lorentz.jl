@@ -61,3 +61,61 @@ function netload(mesh::Mesh, Fdensity::AbstractArray; centroid=[])
     return sum(F, dims=1), sum(M,dims=1)
 end
 
+
+
+"""
+    struct CoilForces
+
+Axial loads between coils made of coaxial rings, from `coilforces`
+
+# Fields
+- `Fz::Vector`: net axial force on each coil [N]
+- `Fr::Vector`: total outward radial (hoop) load on each coil [N]; the net radial 
+    force on a coaxial coil is zero
+- `dFdz::Vector`: change of the net axial force on each coil when it moves along 
+    the axis, all others fixed [N/m]
+- `pairs::Matrix`: axial force on coil i due to coil j, at `[i,j]`
+- `hoop::Matrix`: radial load on coil i due to coil j, at `[i,j]`
+- `stiffness::Matrix`: change of the axial force on coil i when coil j moves along 
+    the axis, at `[i,j]` (its diagonal is `dFdz`)
+"""
+struct CoilForces{T<:Real}
+    Fz::Vector{T}
+    Fr::Vector{T}
+    dFdz::Vector{T}
+    pairs::Matrix{T}
+    hoop::Matrix{T}
+    stiffness::Matrix{T}
+end
+
+
+"""
+    coilforces(coils::Vector{Vector{Ring}}; mu_r=1.0, order=4, Nt=Threads.nthreads())
+
+Calculate the axial forces, hoop loads and axial stiffness between coils, each made 
+of `CircularRing`'s (filaments) or `RectangularRing`'s, all on the Z-axis.
+
+Every pair of filaments in different coils is evaluated once with closed-form 
+elliptic-integral expressions, in the C kernel, split across `Nt` threads. A 
+`RectangularRing` is represented by the `order` x `order` Gauss-Legendre points of its 
+cross-section (2, 4, 8 or 16), which is accurate while coils are further apart than 
+the size of their cross-sections. Forces between filaments of the same coil cancel 
+and are not included.
+
+# Returns
+`CoilForces`
+"""
+function coilforces(coils::AbstractVector{<:Union{Vector{<:CircularRing}, Vector{<:RectangularRing}}}; 
+                    mu_r=1.0, order::Integer=4, Nt::Integer=Threads.nthreads())
+
+    T = findparam(coils[1])
+    filaments = [isa(coil, Vector{<:CircularRing}) ? convertCRings(coil) : convertCFilaments(coil, order) 
+                    for coil in coils]
+    start = Int32.(cumsum([0; length.(filaments)]))
+
+    pairs, hoop, stiffness = bs_cringforces(reduce(vcat, filaments), start; mu_r=mu_r, Nt=Nt)
+    Fz = vec(sum(pairs, dims=2))
+    Fr = vec(sum(hoop, dims=2))
+
+    return CoilForces{T}(Fz, Fr, diag(stiffness), pairs, hoop, stiffness)
+end
@@ -0,0 +1,101 @@
+""" Wired.jl
+    Distributed (multi-process) B-field evaluation with the MPI driver
+"""
+
+mpi_sp = string(@__DIR__)*"/kernel/"*"bfield_mpi_sp"
+mpi_dp = string(@__DIR__)*"/kernel/"*"bfield_mpi_dp"
+
+# Source kinds understood by the MPI driver
+mpikind(::AbstractArray{<:Wire}) = 1
+mpikind(::AbstractArray{<:CircularRing}) = 2
+mpikind(::AbstractArray{<:OrientedRing}) = 3
+mpikind(::AbstractArray{<:RectangularRing}) = 4
+mpikind(::AbstractArray{<:Tetrahedron}) = 5
+mpikind(sources) = error("The MPI driver supports vectors of one type of Wire, Ring or Tetrahedron.")
+
+csources(wires::AbstractArray{<:Wire}) = convertCWires(wires)
+csources(rings::AbstractArray{<:CircularRing}) = convertCRings(rings)
+csources(rings::AbstractArray{<:OrientedRing}) = convertCOrientedRings(rings)
+csources(rings::AbstractArray{<:RectangularRing}) = convertCRectRings(rings)
+csources(tets::AbstractArray{<:Tetrahedron}) = convertCTets(tets)
+
+
+"""
+	installmpi()
+
+Build the MPI driver (`make mpi` in the kernel directory), which needs `mpicc`.
+"""
+function installmpi()
+	kernelguard()
+	current_directory = @__DIR__
+	cd(current_directory*"/kernel")
+	run(`make mpi`);
+	cd(current_directory)
+end
+
+
+"""
+	writejob(path, nodes, sources; mu_r=1.0, errmax=1e-8)
+
+Write the input file of the MPI driver: a 64-byte header, the node coordinates
+(one column after another), then the C definitions of the sources.
+"""
+function writejob(path::AbstractString, nodes::AbstractMatrix{T}, sources::Vector{<:Source};
+					mu_r=1.0, errmax=1e-8) where T<:Real
+	open(path, "w") do io
+		write(io, b"WIREDMPI")
+		write(io, Int64(mpikind(sources)), Int64(sizeof(T)), Int64(size(nodes, 1)),
+				Int64(length(sources)))
+		# Flags: check_inside in bit 0, the singularity policy in bits 1-2
+		write(io, Float64(mu_r), Float64(errmax), Int64(check_inside) | (Int64(singularpolicy()) << 1))
+		write(io, Matrix{T}(nodes))
+		write(io, csources(sources))
+	end
+	return path
+end
+
+
+"""
+	bfield_mpi(nodes, sources; np=2, Nt=1, balance=false, chunksize=0, mu_r=1.0, errmax=1e-8,
+				mpiexec="mpirun", mpiflags=String[], output="", verbose=false)
+
+Calculate the B-field generated by `sources` at `nodes` with several processes, using
+the MPI driver of the C kernel (built on first use with `installmpi`).
+
+The sources are replicated on every process and the nodes are split between them;
+each process runs the natively-threaded kernel with `Nt` threads on its own nodes and
+writes its part of the output file directly. With `balance=true` the nodes are handed
+out in chunks of `chunksize` on demand, so processes that draw nodes which are cheap
+to evaluate (e.g. far from every conductor) take more of them.
+
+Launch options (hosts, oversubscription, ...) are passed on with `mpiflags`, e.g.
+`["--hostfile", "hosts"]`. The output is an Nx3 column-major binary file of the
+precision of the sources, kept at `output` if given.
+
+# Returns
+Nx3 `Matrix` containing magnetic flux density vectors at each of the `nodes`
+"""
+function bfield_mpi(nodes::AbstractMatrix{<:Real}, sources::Vector{<:Source};
+					np::Integer=2, Nt::Integer=1, balance::Bool=false, chunksize::Integer=0,
+					mu_r=1.0, errmax=1e-8, mpiexec="mpirun", mpiflags=String[],
+					output::AbstractString="", verbose::Bool=false)
+
+	P = findparam(sources)
+	exe = (P == Float32) ? mpi_sp : mpi_dp
+	isfile(exe) || installmpi()
+
+	# The temporary files are removed even if the run fails
+	return mktempdir() do dir
+		job = writejob(joinpath(dir, "job.bin"), convert.(P, nodes), sources; mu_r=mu_r, errmax=errmax)
+		out = isempty(output) ? joinpath(dir, "out.bin") : output
+
+		args = ["--threads", string(Nt)]
+		balance && append!(args, ["--balance", "--chunk", string(chunksize)])
+		verbose && push!(args, "--verbose")
+		run(`$mpiexec -np $np $mpiflags $exe $job $out $args`)
+
+		B = Matrix{P}(undef, size(nodes, 1), 3)
+		read!(out, B)
+		B
+	end
+end
@@ -0,0 +1,169 @@
+""" Wired.jl
+    Space-filling-curve (Morton) ordering of nodes and sources for locality
+"""
+
+# Morton permutations of recently seen node and source sets, keyed by a hash of
+# their contents (so a set that is modified in place is sorted again)
+const ordercache = Dict{UInt, Vector{Int}}()
+const ordercachekeys = UInt[]           # oldest first
+const ordercachelock = ReentrantLock()
+const ordercachesize = 16
+
+
+"""
+    spreadbits(v::UInt64)
+
+Spread the low 21 bits of `v` so that there are two zero bits between each.
+"""
+function spreadbits(v::UInt64)
+    v &= 0x1fffff
+    v = (v | v << 32) & 0x1f00000000ffff
+    v = (v | v << 16) & 0x1f0000ff0000ff
+    v = (v | v << 8) & 0x100f00f00f00f00f
+    v = (v | v << 4) & 0x10c30c30c30c30c3
+    v = (v | v << 2) & 0x1249249249249249
+    return v
+end
+
+
+"""
+    mortoncodes(points::AbstractMatrix)
+
+63-bit Morton (Z-order) codes of Nx3 `points`: each coordinate is quantized to 21
+bits over the bounding cube of the points, and the bits are interleaved (x in bit 0,
+y in bit 1, z in bit 2). Matches the C kernel.
+"""
+function mortoncodes(points::AbstractMatrix{<:Real})
+
+    N = size(points, 1)
+    codes = zeros(UInt64, N)
+    N == 0 && return codes
+
+    lo = [Float64(minimum(points[:,k])) for k in 1:3]
+    extent = maximum(Float64(maximum(points[:,k])) - lo[k] for k in 1:3)
+    scale = (extent > 0) ? (2^21 - 1)/extent : 0.0
+
+    for j in 1:N, k in 1:3
+        q = min((Float64(points[j,k]) - lo[k]) * scale, 2^21 - 1)
+        codes[j] |= spreadbits((q > 0) ? unsafe_trunc(UInt64, q) : UInt64(0)) << (k - 1)
+    end
+
+    return codes
+end
+
+
+"""
+    mortonorder(points::AbstractMatrix; Nt=Threads.nthreads())
+
+Permutation that sorts Nx3 `points` along a Morton curve, so that points close
+together in the sorted order are close together in space. With `Wired.kernel = "c"`
+the codes are sorted by the parallel radix sort of the C kernel on `Nt` threads.
+"""
+function mortonorder(points::AbstractMatrix{<:Real}; Nt::Integer=Threads.nthreads())
+    if kernel == "c"
+        P = (eltype(points) == Float32) ? Float32 : Float64
+        return bs_cmortonorder(isa(points, Matrix{P}) ? points : Matrix{P}(points); Nt=Nt)
+    end
+    return sortperm(mortoncodes(points))
+end
+
+
+# Point that stands for a source when sources are ordered
+sourcepoint(wire::Wire) = (wire.a0 .+ wire.a1) ./ 2
+sourcepoint(tet::Tetrahedron) = (tet.nodes[1,:] .+ tet.nodes[2,:] .+ tet.nodes[3,:] .+ tet.nodes[4,:]) ./ 4
+sourcepoint(ring::OrientedRing) = ring.center
+
+
+# Hash of every element of a set (hash() of a large array only samples it)
+function fingerprint(set::AbstractArray)
+    h = hash(size(set))
+    for v in set
+        h = hash(v, h)
+    end
+    return h
+end
+
+
+"""
+    cachedorder(f, set)
+
+Permutation `f()` of a node or source `set`, or the one cached for a set with the
+same contents.
+"""
+function cachedorder(f::Function, set::AbstractArray)
+
+    key = fingerprint(set)
+    perm = lock(ordercachelock) do
+        get(ordercache, key, nothing)
+    end
+    if !isnothing(perm) && length(perm) == size(set, 1)
+        return perm
+    end
+
+    perm = f()
+    lock(ordercachelock) do
+        if !haskey(ordercache, key)
+            push!(ordercachekeys, key)
+            if length(ordercachekeys) > ordercachesize
+                delete!(ordercache, popfirst!(ordercachekeys))
+            end
+        end
+        ordercache[key] = perm
+    end
+
+    return perm
+end
+
+
+"""
+    nodeorder(nodes::AbstractMatrix; Nt=Threads.nthreads())
+
+Morton permutation of a set of nodes (cached).
+"""
+function nodeorder(nodes::AbstractMatrix{<:Real}; Nt::Integer=Threads.nthreads())
+    return cachedorder(() -> mortonorder(nodes; Nt=Nt), nodes)
+end
+
+
+"""
+    sourceorder(sources::Vector{<:Source}; Nt=Threads.nthreads())
+
+Morton permutation of a set of `Wire`, `Tetrahedron` or `OrientedRing` sources by
+their midpoints, centroids or centres (cached). Coaxial rings keep their order.
+"""
+function sourceorder(sources::AbstractVector{<:Union{Wire, Tetrahedron, OrientedRing}};
+                     Nt::Integer=Threads.nthreads())
+    return cachedorder(sources) do
+        mortonorder([sourcepoint(s)[k] for s in sources, k in 1:3]; Nt=Nt)
+    end
+end
+
+sourceorder(sources::AbstractVector{<:Source}; kwargs...) = collect(eachindex(sources))
+
+
+"""
+    inorder(f, nodes, sources; Nt=0, counts=nothing)
+
+Call `f(nodes, sources, counts)` with the nodes and sources sorted along a Morton
+curve, and return its Nx3 result (and add its singular pair counts to `counts`) in
+the caller's order of the nodes.
+"""
+function inorder(f::Function, nodes::AbstractMatrix, sources::AbstractVector;
+                 Nt::Integer=0, counts=nothing)
+
+    Nt = (Nt == 0) ? Threads.nthreads() : Nt
+    p = nodeorder(nodes; Nt=Nt)
+    q = sourceorder(sources; Nt=Nt)
+
+    c = isnothing(counts) ? nothing : zeros(Int32, length(p))
+    Bp = f(nodes[p,:], sources[q], c)
+
+    # Scatter back to the caller's order
+    B = similar(Bp)
+    B[p,:] = Bp
+    if !isnothing(counts)
+        counts[p] .+= c
+    end
+
+    return B
+end
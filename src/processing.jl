@@ -113,4 +113,65 @@ function makecircrings(rect::AbstractArray{RectangularRing{T}}, Nmin=2) where T<
     end
 
     return circ
-end
\ No newline at end of file
+end
+
+# Split of a hexahedron (corners 1-4 around the bottom face, 5-8 around the top 
+# face with 5 above 1) into five tetrahedrons
+const hexsplit = ((1, 2, 4, 5), (2, 3, 4, 7), (2, 5, 6, 7), (4, 5, 7, 8), (2, 4, 5, 7))
+
+"""
+    maketets(coords::AbstractArray, elements::AbstractArray, Jdensity::AbstractArray)
+
+Create Tetrahedron sources from the corner nodes and connectivity of a finite 
+element mesh
+
+Hexahedral elements are split into five tetrahedrons, each carrying the current 
+density of the original element. Degenerate (zero-volume) elements are skipped.
+
+# Arguments 
+- `coords::AbstractArray`: Nx3 matrix of corner node positions
+- `elements::AbstractArray`: Ex4 (tetrahedral) or Ex8 (hexahedral) matrix of corner 
+    node indices (rows of `coords`) for each element. Hexahedral corners are numbered 
+    1-4 around the bottom face and 5-8 around the top face, with 5 above 1.
+- `Jdensity::AbstractArray`: Ex3 matrix of current density vectors for each element
+
+# Returns 
+`Vector{Tetrahedron}` containing all Tetrahedron objects in the mesh
+"""
+function maketets(coords::AbstractArray, elements::AbstractArray, Jdensity::AbstractArray)
+
+    if size(elements)[1] != size(Jdensity)[1]
+        error("Number of elements unequal to number of current density vectors.")
+    end
+
+    if size(elements)[2] == 4 
+        split = ((1, 2, 3, 4),)
+    elseif size(elements)[2] == 8 
+        split = hexsplit 
+    else 
+        error("Elements must have 4 (tetrahedral) or 8 (hexahedral) corner nodes.")
+    end
+
+    tets = Vector{Tetrahedron{precision}}(undef, 0)
+    for i in range(1, size(elements)[1])
+        for corners in split 
+            cornernodes = coords[[elements[i,k] for k in corners], :]
+            if tetvolume(cornernodes) > 0
+                push!(tets, Tetrahedron(cornernodes, Jdensity[i,:]))
+            end
+        end
+    end
+
+    return tets
+end
+
+
+"""
+    maketets(coords::AbstractArray, elements::AbstractArray, mesh::Mesh)
+
+Create Tetrahedron sources using the current density of each element of a Mesh
+"""
+function maketets(coords::AbstractArray, elements::AbstractArray, mesh::Mesh)
+
+    return maketets(coords, elements, mesh.Jdensity)
+end
@@ -0,0 +1,167 @@
+""" Wired.jl
+    Streaming reductions of the field (peak |B|, weighted integrals, flux and
+    homogeneity) that never store the Nx3 field of all nodes
+"""
+
+
+"""
+    struct FieldReduction
+
+Scalar summaries of the field at a set of nodes, returned by `bfield_reduce`. The
+sums are weighted by the node weights w (e.g. volumes or areas; default 1), and
+the extremes of |B| are not.
+
+# Fields
+- `wsum::Float64`: sum of w
+- `Bsum::SVector{3, Float64}`: sum of w B
+- `B1::Float64`: sum of w |B|
+- `B2::Float64`: sum of w |B|^2
+- `flux::Float64`: sum of w (B . n) over the node normals n (0 without normals)
+- `max::Float64`, `argmax::Int`: largest |B| and its node (0 if there are no nodes)
+- `min::Float64`, `argmin::Int`: smallest |B| and its node
+- `nsing::Int`: number of node/source pairs at a singularity (see `Wired.singularity`)
+- `nflagged::Int`: number of nodes left out because they were flagged (`Wired.singularity = "flag"`)
+"""
+struct FieldReduction
+    wsum::Float64
+    Bsum::SVector{3, Float64}
+    B1::Float64
+    B2::Float64
+    flux::Float64
+    max::Float64
+    argmax::Int
+    min::Float64
+    argmin::Int
+    nsing::Int
+    nflagged::Int
+end
+
+FieldReduction(r::CReduction) = FieldReduction(r.wsum, SVector(r.Bsum), r.B1, r.B2, r.flux, r.max, r.argmax + 1,
+                                               r.min, r.argmin + 1, r.nsing, r.nflagged)
+
+
+"""
+    meanfield(r::FieldReduction)
+
+Weighted mean of the field vector.
+"""
+meanfield(r::FieldReduction) = r.Bsum ./ r.wsum
+
+
+"""
+    energy(r::FieldReduction; mu_r=1.0)
+
+Stored magnetic energy, sum(w |B|^2)/(2 mu0 mu_r), when the node weights are the
+volumes that the nodes stand for.
+"""
+energy(r::FieldReduction; mu_r=1.0) = r.B2 / (2 * mu0 * mu_r)
+
+
+"""
+    homogeneity(r::FieldReduction)
+
+Peak-to-peak variation of |B| relative to its weighted mean, (max - min)/mean, e.g.
+over the nodes of a sphere in the bore of a magnet.
+"""
+homogeneity(r::FieldReduction) = (r.max - r.min) / (r.B1 / r.wsum)
+
+
+# Reduction of the field B of the nodes `rows` (with their singular pair counts)
+function reducetile(B::AbstractMatrix, rows::AbstractVector{Int}, weights, normals, counts, policy)
+
+    keep = (policy == 2 && !isnothing(counts)) ? (counts .== 0) : trues(length(rows))
+    Bk = Float64.(B[keep,:])
+    j = rows[keep]
+    w = isnothing(weights) ? ones(length(j)) : Float64.(weights[j])
+    b2 = vec(sum(abs2, Bk; dims=2))
+    b = sqrt.(b2)
+    flux = isnothing(normals) ? 0.0 : sum(w .* vec(sum(Bk .* normals[j,:]; dims=2)); init=0.0)
+    imax = isempty(b) ? 0 : argmax(b)
+    imin = isempty(b) ? 0 : argmin(b)
+
+    return FieldReduction(sum(w; init=0.0), SVector{3}(vec(sum(w .* Bk; dims=1))), sum(w .* b; init=0.0),
+                          sum(w .* b2; init=0.0), flux,
+                          isempty(b) ? 0.0 : b[imax], isempty(b) ? 0 : j[imax],
+                          isempty(b) ? 0.0 : b[imin], isempty(b) ? 0 : j[imin],
+                          isnothing(counts) ? 0 : sum(counts), length(rows) - length(j))
+end
+
+
+# Reduction of two sets of nodes (s after r, so ties keep the first node)
+function combine(r::FieldReduction, s::FieldReduction)
+    takemax = (s.argmax > 0) && (r.argmax == 0 || s.max > r.max)
+    takemin = (s.argmin > 0) && (r.argmin == 0 || s.min < r.min)
+    return FieldReduction(r.wsum + s.wsum, r.Bsum + s.Bsum, r.B1 + s.B1, r.B2 + s.B2, r.flux + s.flux,
+                          takemax ? s.max : r.max, takemax ? s.argmax : r.argmax,
+                          takemin ? s.min : r.min, takemin ? s.argmin : r.argmin,
+                          r.nsing + s.nsing, r.nflagged + s.nflagged)
+end
+
+
+# Whether bfield can count the singular pairs of a kind of source
+hascounts(sources::Vector{<:Source}) = !isa(sources, Vector{<:Tetrahedron})
+
+
+"""
+    bfield_reduce(nodes, sources; weights=nothing, normals=nothing, tile=4096, Nt=0, kwargs...)
+
+Reduce the B-field of `sources` at `nodes` to a `FieldReduction` (peak and minimum
+|B|, weighted sums of B, |B| and |B|^2, and the flux through the node normals),
+without storing the field of all the nodes.
+
+Typical uses: the peak field on a conductor surface, the stored energy (weights:
+node volumes, see `energy`), the flux through a planar or disk surface (weights:
+node areas, normals: the surface normal) and the field homogeneity over a sphere
+(see `homogeneity`).
+
+The nodes are evaluated in tiles of `tile` nodes and each tile is folded into the
+scalars before the next one. With `Wired.kernel = "c"`, `Wire` and `CircularRing`
+sources are reduced inside the C kernel, with the tiles handed out to `Nt` OpenMP
+threads; the result does not depend on `Nt`. Other sources (and the Julia kernel)
+call `bfield` tile by tile, with `kwargs` passed on. Under `Wired.singularity =
+"flag"`, flagged nodes are left out of the reductions (and counted).
+
+# Arguments
+- `nodes::AbstractMatrix`: Nx3 `Matrix` of (x,y,z) coordinates
+- `sources::Vector{<:Source}`: sources contributing to the magnetic field
+- `weights::AbstractVector`: weight of each node (default: 1)
+- `normals::AbstractMatrix`: Nx3 normal vector at each node, for the flux
+- `tile::Integer`: number of nodes evaluated at once
+- `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+"""
+function bfield_reduce(nodes::AbstractMatrix{<:Real}, sources::Vector{<:Source}; weights=nothing,
+                       normals=nothing, tile::Integer=4096, Nt::Integer=0, kwargs...)
+
+    Nn = size(nodes, 1)
+    isnothing(weights) || length(weights) == Nn || error("There must be one weight per node.")
+    isnothing(normals) || size(normals) == (Nn, 3) || error("The normals must be an Nx3 matrix.")
+    Nt = (Nt == 0) ? Threads.nthreads() : Nt
+
+    P = findparam(sources)
+    if kernel == "c" && (isa(sources, Vector{Wire{P}}) || isa(sources, Vector{CircularRing{P}}))
+        mu_r = get(kwargs, :mu_r, 1.0)
+        nodes = convert.(P, nodes)
+        if isa(sources, Vector{Wire{P}})
+            r = bs_cwires_reduce(nodes, sources; weights=weights, normals=normals, mu_r=mu_r, tile=tile, Nt=Nt)
+        else
+            r = bs_crings_reduce(nodes, sources; weights=weights, normals=normals, mu_r=mu_r, tile=tile, Nt=Nt)
+        end
+        return FieldReduction(r)
+    end
+
+    policy = singularpolicy()
+    r = reducetile(zeros(0, 3), Int[], nothing, nothing, nothing, policy)
+    for j0 in 1:tile:Nn
+        rows = collect(j0:min(j0 + tile - 1, Nn))
+        if hascounts(sources)
+            counts = zeros(Int32, length(rows))
+            B = bfield(nodes[rows,:], sources; Nt=Nt, counts=counts, kwargs...)
+        else
+            counts = nothing
+            B = bfield(nodes[rows,:], sources; Nt=Nt, kwargs...)
+        end
+        r = combine(r, reducetile(B, rows, weights, normals, counts, policy))
+    end
+
+    return r
+end
@@ -0,0 +1,220 @@
+""" Wired.jl
+    Stateful evaluation sessions: the field of a fixed set of nodes is kept up to
+    date as sources are moved or re-energized, at a cost that scales with the edit
+"""
+
+
+"""
+    mutable struct Session
+
+Nodes, sources and their field, kept up to date by `update!` and `rescale!`, which
+only evaluate the sources that changed.
+
+The sources are divided into groups (e.g. one per coil). With `keep = true` the
+contribution of every group is stored as well (one Nx3 matrix per group), so the old
+contribution of a group that is replaced or re-energized as a whole does not have to
+be evaluated again, and re-energizing a group costs no kernel call at all.
+
+# Fields
+- `nodes::Matrix`: Nx3 nodes, in the precision of the sources
+- `sources::Vector`: current sources
+- `groups::Vector{Vector{Int}}`: indices of the sources in each group
+- `group::Vector{Int}`: group of each source
+- `B::Matrix`: Nx3 field of all sources at the nodes
+- `parts::Vector{Matrix}`: field of each group (empty unless `keep`)
+- `mu_r`, `errmax`, `Nt`: options of every evaluation
+- `evaluations::Int`: number of node/source pairs evaluated since the last `refresh!`
+"""
+mutable struct Session{T<:AbstractFloat, S<:Source}
+    nodes::Matrix{T}
+    sources::Vector{S}
+    groups::Vector{Vector{Int}}
+    group::Vector{Int}
+    B::Matrix{T}
+    parts::Vector{Matrix{T}}
+    mu_r::Float64
+    errmax::Float64
+    Nt::Int
+    evaluations::Int
+end
+
+
+"""
+    Session(nodes, sources; groups=nothing, keep=false, mu_r=1.0, errmax=1e-8, Nt=0)
+
+Start a session: evaluate the field of `sources` at `nodes` once, and keep it for
+later incremental updates.
+
+# Arguments
+- `nodes::AbstractMatrix`: Nx3 `Matrix` of (x,y,z) coordinates
+- `sources::Vector{<:Source}`: sources contributing to the magnetic field
+- `groups`: `Vector` of index collections that partition the sources (default: every source is its own group)
+- `keep::Bool`: store the contribution of each group (N x 3 x number of groups values)
+- `mu_r`, `errmax`: as for `bfield`
+- `Nt::Integer`: number of threads to use for the calculation (default: all available threads)
+"""
+function Session(nodes::AbstractMatrix{<:Real}, sources::Vector{S}; groups=nothing, keep::Bool=false,
+                 mu_r=1.0, errmax=1e-8, Nt::Integer=0) where S<:Source
+
+    T = findparam(sources)
+    Ns = length(sources)
+    groups = isnothing(groups) ? [[i] for i in 1:Ns] : [collect(Int, g) for g in groups]
+
+    group = zeros(Int, Ns)
+    for (g, idx) in enumerate(groups), i in idx
+        (1 <= i <= Ns) || error("Group $g refers to source $i, but there are $Ns sources.")
+        group[i] == 0 || error("Source $i is in more than one group.")
+        group[i] = g
+    end
+    all(>(0), group) || error("Every source must be in a group.")
+
+    Nt = (Nt == 0) ? Threads.nthreads() : Nt
+    Nn = size(nodes, 1)
+    session = Session{T, S}(Matrix{T}(nodes), copy(sources), groups, group, zeros(T, Nn, 3),
+                            keep ? [zeros(T, Nn, 3) for g in groups] : Matrix{T}[], mu_r, errmax, Nt, 0)
+
+    return refresh!(session)
+end
+
+
+"""
+    bfield(session::Session)
+
+Field of all the sources of a session at its nodes (the session's own Nx3 `Matrix`,
+which later updates modify in place).
+"""
+bfield(session::Session) = session.B
+
+
+"""
+    refresh!(session::Session)
+
+Evaluate the field of every source of a session again, discarding the rounding
+errors accumulated by incremental updates (and the NaN's of nodes flagged by
+`Wired.singularity = "flag"`, if the singular pairs have since moved away).
+"""
+function refresh!(session::Session)
+
+    if isempty(session.parts)
+        session.B .= sessionfield(session, session.sources)
+    else
+        session.B .= 0
+        for (g, idx) in enumerate(session.groups)
+            session.parts[g] .= sessionfield(session, session.sources[idx])
+            session.B .+= session.parts[g]
+        end
+    end
+    session.evaluations = size(session.nodes, 1) * length(session.sources)
+
+    return session
+end
+
+
+"""
+    update!(session::Session, indices, sources)
+
+Replace the sources at `indices` by `sources` (e.g. moved or re-energized copies),
+and update the field by removing the old contribution of those sources and adding
+the new one.
+
+Only the changed sources are evaluated: twice (old and new), or once for groups that
+are replaced as a whole in a session that keeps their contributions.
+"""
+function update!(session::Session{T, S}, indices::AbstractVector{<:Integer},
+                 sources::AbstractVector{<:Source}) where {T<:AbstractFloat, S<:Source}
+
+    length(indices) == length(sources) || error("There must be one new source per index.")
+    allunique(indices) || error("Each source can only be replaced once per update.")
+    isempty(indices) && return session
+
+    Nn = size(session.nodes, 1)
+    new = Vector{S}(sources)
+    old = session.sources[indices]
+
+    if isempty(session.parts)
+        session.B .+= sessionfield(session, new) .- sessionfield(session, old)
+        session.evaluations += 2 * Nn * length(indices)
+    else
+        touched = session.group[indices]
+        for g in unique(touched)
+            k = findall(==(g), touched)
+            if length(k) == length(session.groups[g])
+                # Whole group: its stored contribution is the old field
+                part = sessionfield(session, new[k])
+                session.evaluations += Nn * length(k)
+            else
+                part = session.parts[g] .+ sessionfield(session, new[k]) .- sessionfield(session, old[k])
+                session.evaluations += 2 * Nn * length(k)
+            end
+            session.B .+= part .- session.parts[g]
+            session.parts[g] .= part
+        end
+    end
+
+    session.sources[indices] = new
+    return session
+end
+
+update!(session::Session, index::Integer, source::Source) = update!(session, [index], [source])
+
+
+"""
+    rescale!(session::Session, g::Integer, factor::Real)
+
+Multiply the currents of every source in group `g` by `factor`. In a session that
+keeps the contribution of each group, the field is scaled without any evaluation;
+otherwise the group is updated with `update!`.
+"""
+function rescale!(session::Session, g::Integer, factor::Real)
+
+    idx = session.groups[g]
+    scaled = [scalecurrent(s, factor) for s in session.sources[idx]]
+    if isempty(session.parts)
+        return update!(session, idx, scaled)
+    end
+
+    session.B .+= (factor - 1) .* session.parts[g]
+    session.parts[g] .*= factor
+    session.sources[idx] = scaled
+
+    return session
+end
+
+
+# Copy of a source with its current (density) multiplied by f
+scalecurrent(w::Wire{T}, f::Real) where T = Wire{T}(collect(w.a0), collect(w.a1), f*w.I, w.R)
+scalecurrent(r::CircularRing{T}, f::Real) where T = CircularRing{T}(r.name, r.H, r.R, r.r, f*r.I)
+scalecurrent(r::RectangularRing{T}, f::Real) where T = RectangularRing{T}(r.name, r.H, r.R, r.w, r.h, f*r.I)
+scalecurrent(r::OrientedRing{T}, f::Real) where T = OrientedRing{T}(r.name, collect(r.center), collect(r.normal), r.R, r.r, f*r.I)
+scalecurrent(t::Tetrahedron{T}, f::Real) where T = Tetrahedron{T}(t.nodes, f .* t.J)
+
+
+# Field of some of the sources of a session. With the C kernel the nodes are split
+# across threads inside the kernel, so an update of a handful of sources still uses
+# every thread (splitting the sources would leave most threads idle)
+function sessionfield(s::Session{T}, wires::Vector{Wire{T}}) where T
+    isempty(wires) && return zeros(T, size(s.nodes))
+    kernel == "c" && return bs_cwires_native(s.nodes, wires; mu_r=s.mu_r, Nt=s.Nt)
+    return bfield(s.nodes, wires; mu_r=s.mu_r, Nt=min(s.Nt, length(wires)), reorder=false)
+end
+
+function sessionfield(s::Session{T}, tets::Vector{Tetrahedron{T}}) where T
+    isempty(tets) && return zeros(T, size(s.nodes))
+    kernel == "c" && return bs_ctets_native(s.nodes, tets; mu_r=s.mu_r, Nt=s.Nt)
+    return bfield(s.nodes, tets; mu_r=s.mu_r, Nt=min(s.Nt, length(tets)), reorder=false)
+end
+
+function sessionfield(s::Session{T}, rings::Vector{OrientedRing{T}}) where T
+    isempty(rings) && return zeros(T, size(s.nodes))
+    kernel == "c" && return bs_corientedrings_native(s.nodes, rings; mu_r=s.mu_r, Nt=s.Nt)
+    return bfield(s.nodes, rings; mu_r=s.mu_r, errmax=s.errmax, Nt=min(s.Nt, length(rings)), reorder=false)
+end
+
+function sessionfield(s::Session{T}, rings::Vector{<:Ring}) where T
+    isempty(rings) && return zeros(T, size(s.nodes))
+    if kernel == "c"
+        isa(rings, Vector{CircularRing{T}}) && return bs_crings_native(s.nodes, rings; mu_r=s.mu_r, Nt=s.Nt)
+        isa(rings, Vector{RectangularRing{T}}) && return bs_crectrings_native(s.nodes, rings; mu_r=s.mu_r, errmax=s.errmax, Nt=s.Nt)
+    end
+    return bfield(s.nodes, rings; mu_r=s.mu_r, errmax=s.errmax, Nt=min(s.Nt, length(rings)), reorder=false)
+end
@@ -53,7 +53,7 @@ end
 
 A circular current-carrying ring with circular or rectangular-cross-section.
 
-Major axis of the ring is the Z-axis.
+Major axis of the ring is the Z-axis, except for an `OrientedRing`.
 """
 abstract type Ring <: Source end 
 
@@ -130,3 +130,74 @@ struct RectangularRing{T<:AbstractFloat} <: Ring
     end
 
 end
+
+
+"""
+    struct OrientedRing <: Ring  
+
+A circular current-carrying solid conducting ring with circular cross-section, with 
+an arbitrary centroid and axis
+
+Use for loops that are not coaxial with the Z-axis (e.g. correction coils, saddle 
+coils or tilted loops), which would otherwise have to be discretized into many 
+`Wire` segments.
+
+# Fields 
+- `name::String`: describes the filament
+- `center::SVector{3}`: XYZ coordinates of the ring centroid
+- `normal::SVector{3}`: unit vector along the major axis of the ring; sign convention 
+    for the current follows right-hand rule about this vector
+- `R::Float64`: major radius of the ring
+- `r::Float64`: minor radius of the ring (cross-section radius)
+- `I::Float64`: current in the conducting ring
+"""
+struct OrientedRing{T<:AbstractFloat} <: Ring 
+
+    name::AbstractString
+    center::SVector{3, T}
+    normal::SVector{3, T}
+    R::T
+    r::T
+    I::T
+
+    # The normal vector is normalized to unit length
+    function OrientedRing{T}(name::AbstractString, center::Vector{<:Real}, normal::Vector{<:Real}, 
+                                R::Real, r::Real, I::Real) where T<:AbstractFloat 
+        new(name, convert.(T, center), convert.(T, normal ./ norm(normal)), convert(T,R), convert(T,r), convert(T,I))
+    end
+
+    function OrientedRing(name::AbstractString, center::Vector{<:Real}, normal::Vector{<:Real}, 
+                            R::Real, r::Real, I::Real)
+        OrientedRing{precision}(name, center, normal, R, r, I)
+    end
+
+end
+
+"""
+    struct Tetrahedron <: Source 
+
+A tetrahedral finite element carrying a uniform current density
+
+The magnetic field is found from an exact volume integral over the element, so it 
+is finite and accurate everywhere, including inside and right next to the element. 
+Unlike the `Wire` segments created by `makewires()`, no length/radius ratio is 
+assumed for the element shape. Hexahedral elements are represented by splitting 
+them into tetrahedrons (see `maketets()`).
+
+# Fields 
+- `nodes::SMatrix{4,3}`: XYZ coordinates of the four corner nodes (one per row)
+- `J::SVector{3}`: current density vector in the element
+"""
+struct Tetrahedron{T<:AbstractFloat} <: Source
+    nodes::SMatrix{4, 3, T, 12}
+    J::SVector{3, T}
+
+    function Tetrahedron{T}(nodes::AbstractMatrix{<:Real}, J::AbstractVector{<:Real}) where T<:AbstractFloat
+        new{T}(convert.(T, nodes), convert.(T, J))
+    end
+
+    # Constructor applies Wired.precision by default (convenience method)
+    function Tetrahedron(nodes::AbstractMatrix{<:Real}, J::AbstractVector{<:Real})
+        Tetrahedron{precision}(nodes, J)
+    end
+end
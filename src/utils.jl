@@ -232,6 +232,122 @@ function threadindices(it::Integer, Nt::Integer, N::Integer)
 end
 
 
+"""
+    sumsources(f, B, Nt, Ns, counts)
+
+Add the fields `f(idx, c)` of ranges `idx` of `Ns` sources to `B`, on up to `Nt` 
+Julia tasks at a time, where each task adds the singular pairs of its sources to 
+its own counts `c` (if `counts` are wanted).
+
+Normally each of the `Nt` tasks takes one range (see `threadindices`), so which 
+sources are summed together, and so the rounding of the result, depends on `Nt`. 
+With `Wired.reproducible`, the sources are split into fixed blocks of 
+`Wired.reproblock` sources instead, whatever `Nt`, and the fields of the blocks are 
+added to `B` in block order, so the result is bit-identical for any number of 
+threads. The blocks are not run in waves: a block starts as soon as a thread is 
+free, while the earlier ones are being added.
+"""
+function sumsources(f::Function, B::AbstractArray, Nt::Integer, Ns::Integer, counts)
+
+    if reproducible
+        ranges = [i:min(i + reproblock - 1, Ns) for i in 1:reproblock:Ns]
+    else
+        ranges = [threadindices(it, Nt, Ns) for it in 1:Nt]
+    end
+
+    # Keep up to 2Nt tasks in flight and add their fields in the order of their 
+    # ranges: the next task is spawned as soon as the oldest one is done, so the 
+    # threads keep computing while B is being added to (and at most 2Nt fields are 
+    # alive at a time)
+    function spawnrange(idx)
+        c = isnothing(counts) ? nothing : zeros(Int32, length(counts))
+        return (Threads.@spawn f(idx, c)), c
+    end
+    window = 2*Nt
+    pending = [spawnrange(idx) for idx in ranges[1:min(window, length(ranges))]]
+    for k in eachindex(ranges)
+        task, c = popfirst!(pending)
+        Bk = fetch(task)
+        (k + window <= length(ranges)) && push!(pending, spawnrange(ranges[k + window]))
+        B .+= Bk
+        isnothing(counts) || (counts .+= c)
+    end
+
+    return B
+end
+
+
+"""
+    singularitymode()
+
+The singularity policy in effect: `Wired.singularity`, unless the deprecated 
+`Wired.remove_singularities` is set, in which case `true` maps onto "zero" and 
+`false` onto "flag".
+"""
+function singularitymode()
+    isnothing(remove_singularities) && return singularity
+    @warn "Wired.remove_singularities is deprecated, use Wired.singularity = \"zero\" or \"flag\" instead." maxlog=1
+    return remove_singularities ? "zero" : "flag"
+end
+
+
+"""
+    singularpolicy()
+
+Code of the `singularitymode()` policy shared by the Julia and C kernels: 0 for 
+"zero", 1 for "limit" and 2 for "flag".
+"""
+function singularpolicy()
+    mode = singularitymode()
+    policy = findfirst(==(mode), ["zero", "limit", "flag"])
+    if isnothing(policy)
+        error("Unknown singularity policy \"$mode\". Use \"zero\", \"limit\" or \"flag\".")
+    end
+    return Int32(policy - 1)
+end
+
+
+"""
+    checkzeropolicy(name)
+
+Throw an error naming `name` unless the singularity policy is "zero", for kernels 
+that only handle exact singularities.
+"""
+function checkzeropolicy(name::AbstractString)
+    if singularpolicy() != 0
+        error("$name only supports Wired.singularity = \"zero\".")
+    end
+end
+
+
+"""
+    singulartol2(T, policy)
+
+Squared distance to a singularity, relative to the size of the problem, below which 
+a node/source pair is singular to working precision (64 ulps, or exactly zero for 
+the "zero" policy). Matches the C kernel.
+"""
+singulartol2(::Type{T}, policy::Integer) where T<:AbstractFloat = (policy == 0) ? zero(T) : (64*eps(T))^2
+
+
+"""
+    singularfinish!(B, sing, counts, policy)
+
+Add the number of singular pairs of each node `sing` to `counts` (unless it is 
+`nothing`), and set the field of the nodes with a singular pair to NaN under the 
+"flag" policy. `B` is Nx3, or Nx3xM for several sets of currents.
+"""
+function singularfinish!(B::AbstractArray, sing::AbstractVector, counts, policy::Integer)
+    if policy == 2
+        B[sing .> 0, :, :] .= NaN
+    end
+    if !isnothing(counts)
+        counts .+= sing
+    end
+    return B
+end
+
+
 """
     matrixtotable(A::AbstractArray, header::AbstractArray, digits=1)
 
@@ -270,4 +386,6 @@ end
 # https://discourse.julialang.org/t/get-type-of-field-in-parametric-type/8210/2
 findparam(wires::Vector{<:Wire{T}}) where {T} = T
 findparam(rings::Vector{<:CircularRing{T}}) where {T} = T
-findparam(rings::Vector{<:RectangularRing{T}}) where {T} = T
\ No newline at end of file
+findparam(rings::Vector{<:RectangularRing{T}}) where {T} = T
+findparam(tets::Vector{<:Tetrahedron{T}}) where {T} = T
+findparam(rings::Vector{<:OrientedRing{T}}) where {T} = T
@@ -0,0 +1,243 @@
+""" Wired.jl
+    Zonal harmonic (Legendre) expansions for coaxial ring systems
+"""
+
+
+"""
+    struct ZonalExpansion
+
+Field of a set of coaxial `CircularRing`'s as a zonal harmonic series about a
+point on their axis, in spherical coordinates (r, θ) centred on that point.
+
+Inside a sphere that touches no conductor (`interior`):
+
+    Bz = Σ b_n r^n P_n(cos θ),    Bρ = -Σ b_n r^n sin θ P_n'(cos θ) / (n+1)
+
+and outside a sphere that contains every conductor:
+
+    Bz = Σ e_n r^-(n+3) P_{n+2}(cos θ),    Bρ = Σ e_n r^-(n+3) sin θ P_{n+2}'(cos θ) / (n+2)
+
+where b_n and e_n are the Taylor coefficients of the on-axis field. Every ring adds
+to the same coefficients, so the cost of evaluating the series does not depend on
+the number of rings. The coefficients are stored scaled by the sphere radius `rs`
+(b_n rs^n, or e_n rs^-(n+3)), so they stay of the order of the field.
+
+Reference:
+"Calculation of Fields, Forces, and Mutual Inductances of Current Systems by
+Elliptic Integrals", Garrett (1963), J. Appl. Phys. 34(9)
+
+# Fields
+- `z0::Real`: centre of the expansion on the axis
+- `rs::Real`: radius of the sphere bounding the region of convergence
+- `interior::Bool`: expansion inside (true) or outside (false) the sphere
+- `coeffs::Vector`: scaled coefficients of orders 0 ... N
+"""
+struct ZonalExpansion{T<:Real}
+    z0::T
+    rs::T
+    interior::Bool
+    coeffs::Vector{T}
+end
+
+
+"""
+    ZonalExpansion(rings::Vector{CircularRing}, z0; interior=true, order=100, mu_r=1.0)
+
+Expansion of the field of `rings` about the point (0, 0, `z0`) up to `order`. The
+interior sphere reaches the nearest conductor, and the exterior sphere the furthest.
+
+The on-axis field of a ring of radius a at a distance R from the centre, seen from
+it at an angle with cosine c, is μ0 I a² / 2 (R² - 2Rzc + z²)^-3/2, which expands
+(in z/R, or in R/z) with the Gegenbauer polynomials C_n^(3/2)(c) = P_{n+1}'(c).
+"""
+function ZonalExpansion(rings::AbstractArray{CircularRing{T}}, z0::Real;
+                        interior::Bool=true, order::Integer=100, mu_r=1.0) where T<:Real
+
+    dist = [hypot(ring.R, ring.H - z0) for ring in rings]
+    if interior
+        rs = minimum(dist[i] - rings[i].r for i in eachindex(rings))
+    else
+        rs = maximum(dist[i] + rings[i].r for i in eachindex(rings))
+    end
+
+    coeffs = zeros(Float64, order + 1)
+    P = zeros(Float64, order + 2)
+    dP = zeros(Float64, order + 2)
+    for (i, ring) in enumerate(rings)
+        R = dist[i]
+        legendre!(P, dP, (ring.H - z0)/R)
+        C = mu_r * mu0 * ring.I * ring.R^2 / 2
+        for n in 0:order
+            # P'_{n+1} is dP[n+2]
+            if interior
+                coeffs[n+1] += C / R^3 * dP[n+2] * (rs/R)^n
+            else
+                coeffs[n+1] += C / rs^3 * dP[n+2] * (R/rs)^n
+            end
+        end
+    end
+
+    return ZonalExpansion{T}(z0, rs, interior, convert.(T, coeffs))
+end
+
+
+"""
+    legendre!(P, dP, u)
+
+Legendre polynomials P_n(u) and their derivatives P_n'(u), for n = 0 ... length(P)-1,
+from the three-term recurrence (stable for |u| <= 1).
+"""
+function legendre!(P::AbstractVector, dP::AbstractVector, u::Real)
+    N = length(P)
+    P[1] = 1
+    dP[1] = 0
+    if N > 1
+        P[2] = u
+        dP[2] = 1
+    end
+    for n in 1:N-2
+        P[n+2] = ((2n + 1)*u*P[n+1] - n*P[n]) / (n + 1)
+        dP[n+2] = u*dP[n+1] + (n + 1)*P[n+1]
+    end
+    return P, dP
+end
+
+
+"""
+    bfield(nodes::AbstractArray, expansion::ZonalExpansion)
+
+Evaluate a `ZonalExpansion` at a collection of points (Nx3 `Matrix`). The points are
+assumed to lie in its region of convergence.
+"""
+function bfield(nodes::AbstractArray{<:Real}, expansion::ZonalExpansion{T}) where T<:Real
+
+    c = expansion.coeffs
+    N = length(c) - 1
+    rs = expansion.rs
+    P = zeros(Float64, N + 3)
+    dP = zeros(Float64, N + 3)
+    B = zeros(T, size(nodes, 1), 3)
+
+    for j in axes(nodes, 1)
+        x, y, zl = nodes[j,1], nodes[j,2], nodes[j,3] - expansion.z0
+        r = sqrt(x^2 + y^2 + zl^2)
+        legendre!(P, dP, r > 0 ? zl/r : one(r))
+
+        # Bz, and Bρ/ρ (so that Bx = x Bρ/ρ is finite on the axis)
+        Bz = 0.0
+        S = 0.0
+        if expansion.interior
+            t = r/rs
+            tn = 1.0
+            for n in 0:N
+                Bz += c[n+1] * tn * P[n+1]
+                n < N && (S -= c[n+2] * tn * dP[n+2] / ((n + 2) * rs))
+                tn *= t
+            end
+        else
+            t = rs/r
+            tn = t^3
+            for n in 0:N
+                Bz += c[n+1] * tn * P[n+3]
+                S += c[n+1] * tn * dP[n+3] / ((n + 2) * r)
+                tn *= t
+            end
+        end
+
+        B[j,1] = S * x
+        B[j,2] = S * y
+        B[j,3] = Bz
+    end
+
+    return B
+end
+
+
+"""
+    bfield_zonal(nodes, rings; rtol=1e-10, q=0.9, maxcenters=32, Nmin=2, mu_r=1.0, kwargs...)
+
+Calculate the B-field generated by coaxial `CircularRing` or `RectangularRing` objects
+with zonal harmonic expansions, at a cost per node that does not depend on the number
+of rings (e.g. solenoids and MRI magnets with thousands of turns).
+
+Candidate centres are spread along the axis over the axial extent of the nodes (at
+most `maxcenters`). Each node is assigned to the interior expansion of the centre
+that converges fastest for it, if its distance from that centre is below `q` times
+the radius of convergence. Nodes that no interior expansion covers use one exterior
+expansion about the middle of the rings, if they are beyond its radius by the same
+margin. The rest (e.g. nodes among the windings) fall back to `bfield` with `kwargs`.
+Each expansion is truncated at the order that reaches `rtol` for the nodes it covers.
+
+`RectangularRing`'s are filamentized with `makecircrings` for the expansions.
+
+# Returns
+Nx3 `Matrix` containing magnetic flux density vectors at each of the `nodes`
+"""
+function bfield_zonal(nodes::AbstractMatrix{<:Real}, rings::Union{Vector{<:CircularRing}, Vector{<:RectangularRing}};
+                      rtol=1e-10, q=0.9, maxcenters::Integer=32, Nmin=2, mu_r=1.0, kwargs...)
+
+    P = findparam(rings)
+    circ = isa(rings, Vector{CircularRing{P}}) ? rings : makecircrings(rings, Nmin)
+    Nn = size(nodes, 1)
+    B = zeros(P, Nn, 3)
+    Nn == 0 && return B
+
+    # Smallest order such that (n+1)^2 t^n < rtol, for a worst-case ratio t
+    function order(t)
+        n = 1
+        while n < 2000 && (n + 1)^2 * t^n >= rtol
+            n += 1
+        end
+        return n
+    end
+
+    # Candidate interior centres, spaced a fraction of the smallest bore
+    zmin, zmax = extrema(nodes[:,3])
+    spacing = 0.25 * minimum(ring.R - ring.r for ring in circ)
+    Nc = (spacing > 0) ? clamp(ceil(Int, (zmax - zmin)/spacing) + 1, 1, maxcenters) : 1
+    centers = (Nc == 1) ? [(zmin + zmax)/2] : collect(range(zmin, zmax, length=Nc))
+    radii = [minimum(hypot(ring.R, ring.H - z0) - ring.r for ring in circ) for z0 in centers]
+
+    # Best centre for each node
+    best = zeros(Int, Nn)
+    ratio = fill(Inf, Nn)
+    for j in 1:Nn, k in 1:Nc
+        radii[k] > 0 || continue
+        t = sqrt(nodes[j,1]^2 + nodes[j,2]^2 + (nodes[j,3] - centers[k])^2) / radii[k]
+        if t < ratio[j]
+            ratio[j] = t
+            best[j] = k
+        end
+    end
+
+    for k in 1:Nc
+        rows = findall(j -> best[j] == k && ratio[j] <= q, 1:Nn)
+        isempty(rows) && continue
+        expansion = ZonalExpansion(circ, centers[k]; interior=true,
+                                   order=order(maximum(ratio[rows])), mu_r=mu_r)
+        B[rows,:] = bfield(nodes[rows,:], expansion)
+    end
+
+    # Exterior expansion about the middle of the rings
+    rest = findall(j -> ratio[j] > q, 1:Nn)
+    if !isempty(rest)
+        Hmin, Hmax = extrema(ring.H for ring in circ)
+        z0 = (Hmin + Hmax)/2
+        rs = maximum(hypot(ring.R, ring.H - z0) + ring.r for ring in circ)
+        t = [rs / sqrt(nodes[j,1]^2 + nodes[j,2]^2 + (nodes[j,3] - z0)^2) for j in rest]
+        outside = rest[t .<= q]
+        if !isempty(outside)
+            expansion = ZonalExpansion(circ, z0; interior=false,
+                                       order=order(maximum(t[t .<= q])), mu_r=mu_r)
+            B[outside,:] = bfield(nodes[outside,:], expansion)
+        end
+        rest = rest[t .> q]
+    end
+
+    # Outside every region of convergence
+    if !isempty(rest)
+        B[rest,:] = bfield(convert.(P, nodes[rest,:]), rings; mu_r=mu_r, Nmin=Nmin, kwargs...)
+    end
+
+    return B
+end
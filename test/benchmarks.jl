@@ -7,6 +7,7 @@ using BenchmarkTools, Printf
 
 run_wirebenchmarks = true
 run_ringbenchmarks = false
+run_reprobenchmarks = false
 make_plots = false
 Wired.precision = Float64
 Nvals = [1000, 2000, 4000, 8000, 10000]
@@ -93,6 +94,48 @@ function runringbenchmarks(Nvals::AbstractVector, Nts::AbstractVector)
 end
 
 
+function runreprobenchmarks(Nn::Integer, Ns::Integer, Nts::AbstractVector)
+    # Compare the reproducible mode (Wired.reproducible) with the fast mode for Nn 
+    # nodes and Ns wires, with the Julia and the C kernel, and check that its results 
+    # do not depend on Nt
+
+    # Each row corresponds to a value of Nt; columns: fast and reproducible with the 
+    # Julia kernel, then with the C kernel [ms]
+    times = zeros(length(Nts), 4)
+    nodes = rand(Wired.precision, Nn, 3)
+    wires = createwireproblem(Ns)[2]
+    kernel = Wired.kernel
+    identical = true
+
+    for (m, kern) in enumerate(("julia", "c"))
+        Wired.kernel = kern
+        Bref = nothing
+        for j in range(1, length(Nts))
+            for (k, mode) in enumerate((false, true))
+                Wired.reproducible = mode
+                @printf "Running Wire benchmark with Nn=%i, Ns=%i, kernel=%s, Nt=%i and reproducible=%s\n" Nn Ns kern Nts[j] mode
+                trial = @benchmark bfield($nodes, $wires, Nt=$Nts[$j]);
+                times[j,2m+k-2] = median(trial).time / 1e6
+            end
+            B = bfield(nodes, wires, Nt=Nts[j])
+            Bref = isnothing(Bref) ? B : Bref
+            identical &= (B == Bref)
+            Wired.reproducible = false
+        end
+    end
+    Wired.kernel = kernel
+
+    for (m, kern) in enumerate(("julia", "c")), j in range(1, length(Nts))
+        fast, repro = times[j,2m-1], times[j,2m]
+        @printf "%s kernel, Nt=%i: fast %.1f ms, reproducible %.1f ms (%+.1f%%)\n" kern Nts[j] fast repro 100*(repro/fast - 1)
+    end
+    println("Reproducible results identical for all Nt: " * string(identical))
+
+    return times
+
+end
+
+
 function plotbenchmarks(Nvals, Nts, times, sourcename)
     p = plot()
     for i in range(1, length(Nts))
@@ -129,3 +172,8 @@ if run_ringbenchmarks
 end
 
 
+if run_reprobenchmarks
+
+    # 10^5 nodes and 10^4 wires: many blocks per thread, as in production runs
+    times3 = runreprobenchmarks(100_000, 10_000, Nts)
+end
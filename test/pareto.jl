@@ -0,0 +1,157 @@
+""" Accuracy-versus-speed benchmarks for Wired.jl
+    Every kernel configuration is compared with the extended-precision reference
+    kernel (long double, no fast-math) on representative Wire and Ring problems
+"""
+
+using Wired
+using BenchmarkTools, Printf, Statistics, LinearAlgebra
+
+run_wirepareto = true
+run_ringpareto = true
+N = 2000            # number of nodes and of sources per problem
+Nt = Threads.nthreads()
+
+# Kernel configurations to compare: (kernel, precision, threading, errmax)
+configs = [
+    ("julia", Float64, "julia", 1e-8),
+    ("julia", Float64, "julia", 1e-4),
+    ("julia", Float32, "julia", 1e-8),
+    ("c", Float64, "julia", 1e-8),
+    ("c", Float64, "native", 1e-8),
+    ("c", Float32, "julia", 1e-8),
+    ("c", Float32, "native", 1e-8),
+]
+
+
+function createwireproblem(N; R=0.01)
+    # Random wires, with nodes in three regions: anywhere in the box, close to or
+    # inside a conductor, and on the axis of a wire (inside it or beyond its ends)
+
+    wires = [Wire(rand(3), rand(3), randn(), R) for i in 1:N]
+    bulk = rand(N, 3)
+
+    near = zeros(N, 3)
+    axis = zeros(N, 3)
+    for j in 1:N
+        w = wires[rand(1:N)]
+        a = w.a1 - w.a0
+        u = normalize(cross(a, randn(3)))
+        near[j,:] = w.a0 + rand()*a + R*(0.5 + 1.5*rand())*u
+        w = wires[rand(1:N)]
+        axis[j,:] = w.a0 + (1.4*rand() - 0.2)*(w.a1 - w.a0)
+    end
+
+    return wires, Dict("bulk" => bulk, "near" => near, "axis" => axis)
+end
+
+
+function createringproblem(N; r=0.01)
+    # Random rings, with nodes anywhere in the box, close to or inside a conductor,
+    # and on the common axis
+
+    rings = [CircularRing("", randn(), 0.2 + rand(), r, randn()) for i in 1:N]
+    bulk = [2 .* rand(N, 2) .- 1  2 .* randn(N)]
+
+    near = zeros(N, 3)
+    for j in 1:N
+        ring = rings[rand(1:N)]
+        phi = 2pi*rand()
+        theta = 2pi*rand()
+        d = r*(0.5 + 1.5*rand())
+        near[j,:] = [(ring.R + d*cos(theta))*cos(phi), (ring.R + d*cos(theta))*sin(phi),
+                        ring.H + d*sin(theta)]
+    end
+    axis = [zeros(N, 2)  2 .* randn(N)]
+
+    return rings, Dict("bulk" => bulk, "near" => near, "axis" => axis)
+end
+
+
+# Sources in the precision of a configuration
+convertsources(wires::Vector{<:Wire}, T) = [Wire{T}(collect(w.a0), collect(w.a1), w.I, w.R) for w in wires]
+convertsources(rings::Vector{<:CircularRing}, T) = [CircularRing{T}("", r.H, r.R, r.r, r.I) for r in rings]
+
+
+function relerrors(B, Bref)
+    # Error of each node relative to its reference field; nodes where the reference
+    # field (nearly) vanishes are measured against 1e-6 of the largest field instead
+
+    floor = 1e-6 * maximum(norm, eachrow(Bref))
+    return [norm(B[j,:] .- Bref[j,:]) / max(norm(Bref[j,:]), floor) for j in axes(B, 1)]
+end
+
+
+function runpareto(sources, regions)
+    # Error in every region and throughput (source/node pairs per second) for each
+    # configuration; returns one row per configuration
+
+    names = sort(collect(keys(regions)))
+    refs = Dict(k => Wired.bs_reference(regions[k], sources) for k in names)
+    rows = []
+
+    for (kernel, T, threading, errmax) in configs
+        Wired.kernel = kernel
+        Wired.threading = threading
+        Wired.precision = T
+        S = convertsources(sources, T)
+        kw = isa(sources, Vector{<:CircularRing}) ? (errmax=errmax, Nt=Nt) : (Nt=Nt,)
+
+        errs = Dict{String, Vector{Float64}}()
+        for k in names
+            nodes = convert.(T, regions[k])
+            errs[k] = relerrors(bfield(nodes, S; kw...), refs[k])
+        end
+
+        nodes = convert.(T, regions["bulk"])
+        t = @belapsed bfield($nodes, $S; $kw...)
+        rate = size(nodes, 1) * length(S) / t
+
+        push!(rows, (config="$kernel/$T/$threading/errmax=$errmax", rate=rate,
+                     maxerr=Dict(k => maximum(errs[k]) for k in names),
+                     rmserr=Dict(k => sqrt(mean(errs[k].^2)) for k in names)))
+    end
+
+    Wired.kernel = "julia"
+    Wired.threading = "julia"
+    Wired.precision = Float64
+    return rows, names
+end
+
+
+function printpareto(rows, names, title)
+    # A configuration is on the Pareto front if no other one is both faster and
+    # more accurate (by its worst error over all regions)
+
+    worst(row) = maximum(values(row.maxerr))
+    front = [!any(o.rate > r.rate && worst(o) < worst(r) for o in rows) for r in rows]
+
+    println("\n", title)
+    @printf "%-38s %12s" "configuration" "pairs/s"
+    for k in names
+        @printf " %10s %10s" "max "*k "rms "*k
+    end
+    println("  pareto")
+    for (r, onfront) in sort(collect(zip(rows, front)), by = x -> -x[1].rate)
+        @printf "%-38s %12.4g" r.config r.rate
+        for k in names
+            @printf " %10.2e %10.2e" r.maxerr[k] r.rmserr[k]
+        end
+        println(onfront ? "  *" : "")
+    end
+end
+
+
+if run_wirepareto
+    Wired.precision = Float64
+    wires, regions = createwireproblem(N)
+    rows, names = runpareto(wires, regions)
+    printpareto(rows, names, "Wire sources: relative error of B against the extended-precision reference")
+end
+
+
+if run_ringpareto
+    Wired.precision = Float64
+    rings, regions = createringproblem(N)
+    rows, names = runpareto(rings, regions)
+    printpareto(rows, names, "Ring sources: relative error of B against the extended-precision reference")
+end
@@ -8,6 +8,17 @@ using Test, BenchmarkTools
 
     include("test_wire.jl")
     include("test_rings.jl")
+    include("test_native.jl")
+    include("test_tet.jl")
+    include("test_adaptive.jl")
+    include("test_cache.jl")
+    include("test_async.jl")
+    include("test_mpi.jl")
+    include("test_harmonic.jl")
+    include("test_ordering.jl")
+    include("test_session.jl")
+    include("test_reduce.jl")
+    include("test_repro.jl")
     println("SETTING PRECISION TO DOUBLE")
     Wired.precision = Float64
     println("USING JULIA KERNEL")
@@ -15,15 +26,49 @@ using Test, BenchmarkTools
     @test testwire1()
     @test testwire2()
     @test testwire3()
+    @test testsingular()
     @test testring_circular()
     @test testring_rectangular()
+    @test testring_oriented()
+    @test testmulti()
+    @test testring_zonal()
+    @test testreorder()
+    @test testsession()
+    @test testreduce()
+    @test testreproducible()
+    @test testtet1()
+    @test testtet2()
+    @test testadaptive()
+    @test testcache()
+    @test testasync()
     println("USING C KERNEL")
     Wired.kernel = "c"
     @test testwire1()
     @test testwire2()
     @test testwire3()
-    # @test testring_circular()
-    # @test testring_rectangular()
+    @test testsingular()
+    @test testnative_wires()
+    @test testbatch_wires()
+    @test testvjp_wires()
+    @test testtet1()
+    @test testtet2()
+    @test testadaptive()
+    @test testcache()
+    @test testasync()
+    @test testring_circular()
+    @test testring_rectangular()
+    @test testring_oriented()
+    @test testmulti()
+    @test testring_zonal()
+    @test testreorder()
+    @test testsession()
+    @test testreduce()
+    @test testreproducible()
+    @test testring_rectquadrature()
+    @test testring_forces()
+    if Sys.which("mpirun") !== nothing
+        @test testmpi()
+    end
     println("SETTING PRECISION TO SINGLE")
     Wired.precision = Float32
     println("USING JULIA KERNEL")
@@ -31,15 +76,40 @@ using Test, BenchmarkTools
     @test testwire1()
     @test testwire2()
     @test testwire3()
+    @test testsingular()
     @test testring_circular()
     @test testring_rectangular()
+    @test testring_oriented()
+    @test testmulti()
+    @test testreorder()
+    @test testsession()
+    @test testreduce()
+    @test testreproducible()
+    @test testtet1()
+    @test testtet2()
     println("USING C KERNEL")
     Wired.kernel = "c"
     @test testwire1()
     @test testwire2()
     @test testwire3()
-    # @test testring_circular()
-    # @test testring_rectangular()
+    @test testsingular()
+    @test testnative_wires()
+    @test testbatch_wires()
+    @test testvjp_wires()
+    @test testtet1()
+    @test testtet2()
+    @test testring_circular()
+    @test testring_rectangular()
+    @test testring_oriented()
+    @test testmulti()
+    @test testreorder()
+    @test testsession()
+    @test testreduce()
+    @test testreproducible()
+    @test testring_rectquadrature()
+    if Sys.which("mpirun") !== nothing
+        @test testmpi()
+    end
     Wired.precision = Float64
 
 
@@ -48,5 +118,6 @@ using Test, BenchmarkTools
 
     include("test_fields.jl")
     @test test_line()
+    @test test_grid()
 
 end
@@ -0,0 +1,36 @@
+using Wired
+using LinearAlgebra: norm
+
+
+function testadaptive(N=24)
+    # Check an adaptive map of a small loop against direct evaluation at scattered 
+    # points, and that it needs far fewer evaluations than a uniform map of the 
+    # same finest resolution
+
+    println("Testing Adaptive Field Map")
+
+    center = [0.5, 0.4, 0.05]
+    R = 0.15
+    point(t) = center .+ R .* [cos(t), sin(t), 0.0]
+    wires = [Wire(point(2pi*(i-1)/N), point(2pi*i/N), 1000, 0.01) for i in 1:N]
+
+    lo = [-1.0, -1.0, -0.5]
+    hi = [1.0, 1.0, 0.5]
+    tree = bfield_adaptive(lo, hi, wires; rtol=1e-3, N0=4, maxdepth=5)
+
+    # Scattered (low-discrepancy) points in the box 
+    alpha = [0.7548776662466927, 0.5698402909980532, 0.4301597090019468]
+    nodes = [lo[d] + (hi[d] - lo[d])*mod(i*alpha[d], 1) for i in 1:500, d in 1:3]
+    B = bfield(nodes, wires)
+    err = [norm(r) for r in eachrow(interpolate(tree, nodes) .- B)] ./ maximum(norm, eachrow(B))
+
+    uniform = (4*2^5 + 1)^3
+    test1 = count(err .< 1e-2) >= 0.98*length(err)
+    test2 = size(tree.nodes, 1) < uniform/10
+
+    if test1 && test2
+        return true 
+    else 
+        return false 
+    end
+end
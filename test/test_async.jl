@@ -0,0 +1,34 @@
+using Wired
+
+
+function testasync()
+    # Check that a background job gives the same result as a blocking call, and 
+    # that a cancelled job stops early with correct results for finished chunks
+
+    println("Testing Asynchronous Jobs")
+
+    wires = [Wire([0.1, -0.2, -0.5], [0.3, 0.1, 0.6], 1000, 0.01), 
+             Wire([0.3, 0.1, 0.6], [-0.4, 0.2, 0.1], 500, 0.01)]
+    nodes = [0.5 0.0 0.0; 0.0 0.7 0.2; -0.3 0.4 -0.1; 0.2 0.2 0.9; 1.0 1.0 1.0]
+    B = bfield(nodes, wires)
+
+    job = submit(nodes, wires; chunksize=2)
+    test1 = isapprox(fetch(job), B) && status(job) == :done && progress(job) == 1.0
+
+    # Many single-node chunks, cancelled straight away
+    bignodes = repeat(nodes, 200)
+    job = submit(bignodes, wires; chunksize=1)
+    cancel!(job)
+    wait(job)
+    rows, Bpart = partial(job)
+    test2 = status(job) in (:cancelled, :done) && isready(job)
+    test3 = isapprox(Bpart, bfield(bignodes[rows,:], wires)) && 
+            progress(job) == length(rows) / size(bignodes, 1)
+    test4 = status(job) == :done || (try fetch(job); false catch; true end)
+
+    if test1 && test2 && test3 && test4
+        return true 
+    else 
+        return false 
+    end
+end
@@ -0,0 +1,53 @@
+using Wired
+
+
+function testcache()
+    # Check that cached results match direct calculation, that full hits never 
+    # reach the kernel, and that partial hits only add the new points
+
+    println("Testing On-Disk Cache")
+
+    wires = [Wire([0.1, -0.2, -0.5], [0.3, 0.1, 0.6], 1000, 0.01), 
+             Wire([0.3, 0.1, 0.6], [-0.4, 0.2, 0.1], 500, 0.01)]
+    nodes1 = [0.5 0.0 0.0; 0.0 0.7 0.2; -0.3 0.4 -0.1; 0.2 0.2 0.9]
+    nodes2 = [nodes1[2:3,:]; 1.0 1.0 1.0; 0.6 -0.5 0.3]
+
+    dir = mktempdir()
+    B1 = bfield_cached(nodes1, wires; cachedir=dir)
+    test1 = isapprox(B1, bfield(nodes1, wires))
+
+    # A full hit is served from the cache: with the stored fields overwritten, the
+    # overwritten values come back rather than recalculated ones
+    file = only(filter(f -> endswith(f, ".bin"), readdir(dir; join=true)))
+    records = copy(Wired.readcache(file))
+    tampered = copy(records)
+    tampered[4:6,:] .= 0
+    Wired.writecache(file, tampered)
+    test2 = all(iszero, bfield_cached(nodes1, wires; cachedir=dir))
+    Wired.writecache(file, records)
+
+    # A partial hit adds only the two new points
+    B2 = bfield_cached(nodes2, wires; cachedir=dir)
+    test3 = isapprox(B2, bfield(nodes2, wires))
+    files = filter(f -> endswith(f, ".bin"), readdir(dir; join=true))
+    test4 = length(files) == 1 && size(Wired.readcache(files[1]), 2) == 6
+
+    # Different options use a different cache entry
+    B3 = bfield_cached(nodes1, wires; cachedir=dir, mu_r=2.0)
+    test5 = isapprox(B3, 2 .* B1) && length(filter(f -> endswith(f, ".bin"), readdir(dir))) == 2
+
+    # The kernel is part of the key, since the kernels do not all agree bit for bit
+    kernel = Wired.kernel
+    key1 = Wired.cachekey(wires)
+    Wired.kernel = (kernel == "c") ? "julia" : "c"
+    test6 = Wired.cachekey(wires) != key1
+    Wired.kernel = kernel
+
+    rm(dir; recursive=true)
+
+    if test1 && test2 && test3 && test4 && test5 && test6
+        return true 
+    else 
+        return false 
+    end
+end
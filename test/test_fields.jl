@@ -16,4 +16,34 @@ function test_line(start=[0,0,0], stop=[1,1,1], N=100)
     else
         return false 
     end
-end
\ No newline at end of file
+end
+
+function test_grid()
+    # Check that grid fields, whose points are generated by the kernel, match the 
+    # same points passed in as a matrix
+
+    println("Testing Grid")
+
+    wires = [Wire([-0.31, 0.12, -0.23], [0.27, -0.18, 0.41], 1000, 0.01), 
+             Wire([0.27, -0.18, 0.41], [0.05, 0.33, -0.37], -500, 0.01)]
+    grid = CartesianGrid(range(-0.5, 0.5, 21), range(-0.4, 0.4, 17), range(-0.6, 0.6, 13))
+    test1 = isapprox(bfield(grid, wires), bfield(fieldnodes(grid), wires), rtol=1e-5)
+
+    plane = PlaneGrid([-0.5, -0.5, 0.1], [1.0, 0.2, 0.0], [0.0, 0.3, 0.9], 15, 11)
+    test2 = isapprox(bfield(plane, wires), bfield(fieldnodes(plane), wires), rtol=1e-5)
+
+    rings = [CircularRing("name", 0.2, 1.0, 0.05, 1000), CircularRing("name", -0.3, 0.55, 0.05, -300)]
+    cyl = CylindricalGrid(range(0.05, 1.45, 15), range(0.3, 2pi, 9), range(-0.53, 0.57, 12))
+    test3 = isapprox(bfield(cyl, rings), bfield(fieldnodes(cyl), rings), rtol=1e-5)
+    test4 = size(bfield(cyl, rings)) == (prod(size(cyl)), 3)
+
+    # No grid point lies on a ring filament
+    counts = zeros(Int32, prod(size(cyl)))
+    test5 = isapprox(bfield(cyl, rings; counts=counts), bfield(fieldnodes(cyl), rings), rtol=1e-5) && all(iszero, counts)
+
+    if test1 && test2 && test3 && test4 && test5
+        return true 
+    else
+        return false 
+    end
+end
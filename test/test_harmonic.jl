@@ -0,0 +1,36 @@
+""" Tests for sources driven by several sets of currents
+"""
+
+function testmulti(Nn=100, Ns=30, M=4)
+    # Check that each set of currents matches a separate evaluation with those 
+    # currents, and that phasor currents give the real and imaginary fields
+
+    println("Testing Multiple Currents - Wire and Ring")
+
+    nodes = rand(Wired.precision, Nn, 3)
+    I = randn(Ns, M)
+    wires = [Wire(rand(3), rand(3), 0.0, 0.01) for i in 1:Ns]
+    rings = [CircularRing("", randn(), 0.5 + rand(), 0.01, 0.0) for i in 1:Ns]
+
+    for sources in (wires, rings)
+        B = bfield_multi(nodes, sources, I)
+        for m in 1:M
+            if isa(sources, Vector{<:Wire})
+                single = [Wire(collect(w.a0), collect(w.a1), I[i,m], w.R) for (i, w) in enumerate(sources)]
+            else
+                single = [CircularRing("", r.H, r.R, r.r, I[i,m]) for (i, r) in enumerate(sources)]
+            end
+            if !isapprox(B[:,:,m], bfield(nodes, single), rtol=1e-4)
+                return false
+            end
+        end
+
+        Ic = complex.(I[:,1], I[:,2])
+        Bc = bfield_multi(nodes, sources, Ic)
+        if !isapprox(Bc, complex.(B[:,:,1], B[:,:,2]), rtol=1e-4)
+            return false
+        end
+    end
+
+    return true
+end
@@ -0,0 +1,28 @@
+using Wired
+
+
+function testmpi(N=2000)
+    # Check that the distributed driver matches a single-process calculation, with 
+    # one slice per process and with load-balanced chunks
+
+    println("Testing MPI Driver")
+
+    nodes = rand(Wired.precision, N, 3)
+    wires = [Wire(rand(3), rand(3), randn(), 0.01) for i in 1:50]
+    rings = [RectangularRing("ring", rand(), 0.5 + rand(), 0.05, 0.1, randn()) for i in 1:10]
+    flags = ["--oversubscribe"]
+
+    B1 = bfield(nodes, wires)
+    test1 = isapprox(bfield_mpi(nodes, wires; np=4, mpiflags=flags), B1, rtol=1e-4)
+    test2 = isapprox(bfield_mpi(nodes, wires; np=3, balance=true, chunksize=64, mpiflags=flags), 
+                     B1, rtol=1e-4)
+
+    B2 = bfield(nodes, rings)
+    test3 = isapprox(bfield_mpi(nodes, rings; np=2, balance=true, mpiflags=flags), B2, rtol=1e-4)
+
+    if test1 && test2 && test3
+        return true 
+    else 
+        return false 
+    end
+end
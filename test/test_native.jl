@@ -0,0 +1,76 @@
+using Wired
+
+
+function testnative_wires(N=500)
+    # Check that the natively-threaded C kernel matches the Julia-threaded one
+
+    println("Testing Native Threading - Wire")
+
+    nodes = rand(Wired.precision, N, 3)
+    wires = [Wire(rand(3), rand(3), randn(), 0.01) for i in 1:N]
+    Nt = Threads.nthreads()
+
+    Wired.threading = "julia"
+    B1 = bfield(nodes, wires; Nt=Nt)
+    Wired.threading = "native"
+    B2 = bfield(nodes, wires; Nt=Nt)
+    stats = kernelstats()
+    Wired.threading = "julia"
+
+    # Every node must be owned by exactly one thread
+    covered = sum(s.n1 - s.n0 for s in stats.threads) == N
+
+    if isapprox(B1, B2, rtol=1e-4) && length(stats.threads) == Nt && covered
+        return true 
+    else 
+        return false 
+    end
+end
+
+
+function testbatch_wires(Np=20, Nw=50, Nn=100)
+    # Check that a batch of problems matches solving each problem on its own
+
+    println("Testing Batched Problems - Wire")
+
+    nodes = [rand(Wired.precision, Nn, 3) for p in 1:Np]
+    wires = [[Wire(rand(3), rand(3), randn(), 0.01) for i in 1:Nw] for p in 1:Np]
+
+    B = bfield_batch(nodes, wires)
+    Bshared = bfield_batch(nodes[1], wires)
+
+    for p in 1:Np
+        if !isapprox(B[p], bfield(nodes[p], wires[p]), rtol=1e-4)
+            return false 
+        end
+        if !isapprox(Bshared[p], bfield(nodes[1], wires[p]), rtol=1e-4)
+            return false 
+        end
+    end
+
+    return true
+end
+
+
+function testvjp_wires(Nn=50, Nw=10)
+    # Check the adjoint-mode gradient against the forward-mode Jacobian, and the 
+    # current derivative against B/I
+
+    println("Testing Sensitivities - Wire")
+
+    nodes = rand(Wired.precision, Nn, 3)
+    wires = [Wire(rand(3), rand(3), 1.0 + rand(), 0.01) for i in 1:Nw]
+    G = rand(Wired.precision, Nn, 3)
+
+    B1, grad = bfield_vjp(nodes, wires, G)
+    B2, J = bfield_jacobian(nodes, wires)
+
+    grad_ = [sum(G .* J[:,:,i,k]) for i in 1:Nw, k in 1:7]
+    dBdI = sum(J[:,:,i,7] .* wires[i].I for i in 1:Nw)
+
+    if isapprox(B1, B2, rtol=1e-4) && isapprox(grad, grad_, rtol=1e-3) && isapprox(dBdI, B1, rtol=1e-4)
+        return true 
+    else 
+        return false 
+    end
+end
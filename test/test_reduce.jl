@@ -0,0 +1,44 @@
+""" Tests for streaming reductions of the field
+"""
+
+function testreduce(Nn=3000, Ns=30)
+    # Compare the reductions with the same quantities computed from the full field, 
+    # for tiles that do and do not divide the number of nodes
+
+    println("Testing Reductions - Wire, Ring and Tetrahedron")
+
+    nodes = rand(Wired.precision, Nn, 3)
+    weights = rand(Nn)
+    normals = randn(Nn, 3)
+    normals ./= sqrt.(sum(abs2, normals; dims=2))
+
+    wires = [Wire(rand(3), rand(3), randn(), 0.01) for i in 1:Ns]
+    rings = [CircularRing("", randn(), 0.5 + rand(), 0.01, randn()) for i in 1:Ns]
+    coords, elements = hexgrid(range(0, 1, 3), range(0, 1, 3), range(0, 1, 3))
+    tets = maketets(coords, elements, randn(size(elements, 1), 3))
+
+    passed = true
+    for sources in (wires, rings, tets), tile in (256, 1000, 5000)
+        B = Float64.(bfield(nodes, sources))
+        b = sqrt.(vec(sum(abs2, B; dims=2)))
+        r = bfield_reduce(nodes, sources; weights=weights, normals=normals, tile=tile)
+
+        passed &= isapprox(r.wsum, sum(weights), rtol=1e-10)
+        passed &= isapprox(meanfield(r), vec(sum(weights .* B; dims=1)) ./ sum(weights), rtol=1e-4)
+        passed &= isapprox(r.B2, sum(weights .* b.^2), rtol=1e-4)
+        passed &= isapprox(r.flux, sum(weights .* vec(sum(B .* normals; dims=2))), rtol=1e-3, atol=1e-6*maximum(b)*Nn)
+        passed &= isapprox(r.max, maximum(b), rtol=1e-4) && isapprox(r.min, minimum(b), rtol=1e-4)
+        passed &= isapprox(b[r.argmax], r.max, rtol=1e-4) && isapprox(b[r.argmin], r.min, rtol=1e-4)
+        passed &= isapprox(homogeneity(r), (maximum(b) - minimum(b)) / (sum(weights .* b) / sum(weights)), rtol=1e-3)
+    end
+
+    # Flagged nodes are left out
+    Wired.singularity = "flag"
+    axis = copy(nodes)
+    axis[11,:] = wires[1].a0 .+ 0.5 .* (wires[1].a1 .- wires[1].a0)
+    r = bfield_reduce(axis, wires; tile=1000)
+    passed &= (r.nflagged == 1) && (r.nsing >= 1) && isfinite(r.B2)
+    Wired.singularity = "zero"
+
+    return passed
+end
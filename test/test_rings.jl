@@ -53,3 +53,133 @@ function testring_rectangular()
 end
 
 
+
+
+function testring_oriented(N=400)
+    # Check a tilted ring against the same loop made of many Wire segments, and 
+    # against a CircularRing when its axis is the Z-axis
+
+    println("Testing Ring - Oriented")
+
+    center = [0.2, -0.1, 0.3]
+    normal = [0.3, -0.5, 0.8]
+    R = 1.2
+    Iring = 1000
+    ring = OrientedRing("name", center, normal, R, 0.01, Iring)
+
+    # Loop of N straight segments, counter-clockwise about the normal
+    n = normal ./ sqrt(sum(normal.^2))
+    e1 = [n[2], -n[1], 0.0] ./ sqrt(n[1]^2 + n[2]^2)
+    e2 = [n[2]*e1[3] - n[3]*e1[2], n[3]*e1[1] - n[1]*e1[3], n[1]*e1[2] - n[2]*e1[1]]
+    point(t) = center .+ R .* (cos(t) .* e1 .+ sin(t) .* e2)
+    wires = [Wire(point(2pi*(i-1)/N), point(2pi*i/N), Iring, 0.0) for i in 1:N]
+
+    nodes = [0.3 0.4 0.9; 0.0 0.5 0.2; 1.5 -0.2 -0.3; 0.0 -2.0 1.0]
+    test1 = isapprox(bfield(nodes, [ring]), bfield(nodes, wires), rtol=1e-3)
+
+    # Axis-aligned ring, including points inside the conductor and on the axis
+    H = 0.4
+    circ = CircularRing("name", H, 1.0, 0.1, Iring)
+    aligned = OrientedRing("name", [0, 0, H], [0, 0, 1], 1.0, 0.1, Iring)
+    nodes = [0.0 0.0 0.0; 0.0 0.5 0.2; 1.02 0.0 0.43; 0.3 -0.8 H; 2.0 1.0 -1.0]
+    test2 = isapprox(bfield(nodes, [aligned]), bfield(nodes, [circ]), rtol=1e-4)
+
+    if test1 && test2
+        return true 
+    else 
+        return false 
+    end
+end
+
+
+function testring_rectquadrature()
+    # Check the direct cross-section integral of the C kernel against a fine 
+    # filament model, and the native threading mode against the serial one 
+    # (including points inside and just outside the conductor)
+
+    println("Testing Ring - Rectangular Quadrature")
+
+    rect = RectangularRing("name", 0.2, 1.0, 0.05, 0.3, 1000)
+    circ = makecircrings([rect], 40)
+
+    nodes = [0.0 0.0 0.0; 0.3 0.4 0.9; 1.2 0.3 0.1; 0.2 -3.0 1.0]
+    test1 = isapprox(bfield(nodes, [rect]), bfield(nodes, circ), rtol=1e-4)
+
+    nodes = [1.0 0.0 0.2; 0.6 0.8 0.35; 1.03 0.0 0.3; 0.0 1.0 0.2]
+    B = Wired.biotsavart(nodes, [rect])
+    Wired.threading = "native"
+    Bn = bfield(nodes, [rect])
+    Wired.threading = "julia"
+    test2 = all(isfinite, B) && isapprox(B, Bn, rtol=1e-5)
+
+    if test1 && test2
+        return true 
+    else 
+        return false 
+    end
+end
+
+
+function testring_zonal()
+    # Check zonal harmonic expansions of a solenoid against direct evaluation, in 
+    # the bore, far outside, and among the windings (direct fallback)
+
+    println("Testing Ring - Zonal Harmonics")
+
+    rings = [CircularRing("turn", H, 0.3, 0.002, 10.0) for H in range(-0.5, 0.5, length=200)]
+    bore = [0.2 .* rand(100, 2) .- 0.1  1.2 .* rand(100) .- 0.6]
+    far = [3.0 0.0 0.0; 0.0 -2.0 1.5; 1.0 1.0 -4.0]
+    near = [0.305 0.0 0.1; 0.0 0.31 -0.2]
+    nodes = [bore; far; near]
+
+    B = bfield_zonal(nodes, rings; rtol=1e-10)
+    Bd = bfield(nodes, rings)
+    test1 = isapprox(B, Bd, rtol=1e-6)
+
+    # A single expansion about the centre of the bore
+    centre = 0.1 .* rand(10, 3) .- 0.05
+    expansion = ZonalExpansion(rings, 0.0; order=60)
+    test2 = isapprox(bfield(centre, expansion), bfield(centre, rings), rtol=1e-6)
+
+    if test1 && test2
+        return true 
+    else 
+        return false 
+    end
+end
+
+
+function testring_forces()
+    # Check coil forces against the field of the other coil, Newton's third law, 
+    # finite differences of the force, and a fine filament model of a rectangular coil
+
+    println("Testing Ring - Coil Forces")
+
+    coil1 = [CircularRing("a", 0.0, 1.0, 0.01, 1000), CircularRing("b", 0.05, 1.02, 0.01, 1000)]
+    coil2 = [CircularRing("c", 0.3, 0.8, 0.01, -500)]
+    coil3 = [CircularRing("d", -0.4, 1.5, 0.01, 2000)]
+    F = coilforces([coil1, coil2, coil3])
+
+    # Axial force on a single filament: -2pi b I B_rho
+    B = bfield([0.8 0.0 0.3], [coil1; coil3])
+    test1 = isapprox(F.Fz[2], -2pi * 0.8 * -500 * B[1], rtol=1e-6)
+    test2 = isapprox(F.pairs, -F.pairs', atol=1e-9*maximum(abs, F.pairs))
+
+    h = 1e-5
+    shift(coil, dz) = [CircularRing("", r.H + dz, r.R, r.r, r.I) for r in coil]
+    Fup = coilforces([coil1, shift(coil2, h), coil3])
+    Fdn = coilforces([coil1, shift(coil2, -h), coil3])
+    test3 = isapprox(F.dFdz[2], (Fup.Fz[2] - Fdn.Fz[2])/(2h), rtol=1e-5) && 
+            isapprox(F.stiffness[:,2], (Fup.Fz .- Fdn.Fz)./(2h), rtol=1e-5)
+
+    rect = [RectangularRing("e", 0.5, 1.0, 0.05, 0.1, 1000)]
+    Frect = coilforces([coil1, rect]; order=8)
+    Ffine = coilforces([coil1, makecircrings(rect, 20)])
+    test4 = isapprox(Frect.Fz, Ffine.Fz, rtol=1e-3) && isapprox(Frect.Fr, Ffine.Fr, rtol=1e-3)
+
+    if test1 && test2 && test3 && test4
+        return true 
+    else 
+        return false 
+    end
+end
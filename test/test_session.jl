@@ -0,0 +1,47 @@
+""" Tests for incremental evaluation sessions
+"""
+
+function testsession(Nn=200, Ns=60)
+    # Move and re-energize some sources of a session, with and without stored group 
+    # contributions, and compare with a fresh evaluation of the edited sources
+
+    println("Testing Session - Wire and Ring")
+
+    nodes = rand(Wired.precision, Nn, 3)
+    wires = [Wire(rand(3), rand(3), randn(), 0.01) for i in 1:Ns]
+    rings = [CircularRing("", randn(), 0.5 + rand(), 0.01, randn()) for i in 1:Ns]
+    groups = [1:20, 21:40, 41:60]
+
+    passed = true
+    for sources in (wires, rings), keep in (false, true)
+        session = Session(nodes, sources; groups=groups, keep=keep)
+        passed &= isapprox(bfield(session), bfield(nodes, sources), rtol=1e-4)
+
+        # Move two sources of one group
+        moved = isa(sources, Vector{<:Wire}) ? 
+                    [Wire(collect(w.a0) .+ 0.1, collect(w.a1) .+ 0.1, w.I, w.R) for w in sources[[3, 5]]] :
+                    [CircularRing("", r.H + 0.1, r.R, r.r, r.I) for r in sources[[3, 5]]]
+        n = session.evaluations
+        update!(session, [3, 5], moved)
+        passed &= (session.evaluations - n == 4 * Nn)
+
+        # Replace a whole group, then re-energize another one
+        update!(session, collect(groups[2]), [Wired.scalecurrent(s, -1) for s in session.sources[groups[2]]])
+        rescale!(session, 3, 2.5)
+
+        edited = copy(sources)
+        edited[[3, 5]] = moved
+        edited[groups[2]] = [Wired.scalecurrent(s, -1) for s in sources[groups[2]]]
+        edited[groups[3]] = [Wired.scalecurrent(s, 2.5) for s in sources[groups[3]]]
+        passed &= (session.sources == edited)
+        passed &= isapprox(bfield(session), bfield(nodes, edited), rtol=1e-4)
+
+        # Stored contributions avoid evaluating the old group and scaling costs nothing
+        evals = keep ? 4 * Nn + 20 * Nn : 4 * Nn + 40 * Nn + 40 * Nn
+        passed &= (session.evaluations - n == evals)
+
+        passed &= isapprox(bfield(refresh!(session)), bfield(nodes, edited), rtol=1e-4)
+    end
+
+    return passed
+end
@@ -0,0 +1,65 @@
+using Wired
+
+
+function hexgrid(x, y, z)
+    # Corner nodes and connectivity of a structured grid of hexahedral elements
+
+    nx, ny, nz = length(x), length(y), length(z)
+    coords = reduce(vcat, [[xi yj zk] for zk in z for yj in y for xi in x])
+    id(i, j, k) = i + (j-1)*nx + (k-1)*nx*ny
+
+    elements = zeros(Int, (nx-1)*(ny-1)*(nz-1), 8)
+    e = 1
+    for k in 1:nz-1, j in 1:ny-1, i in 1:nx-1
+        elements[e,:] = [id(i,j,k), id(i+1,j,k), id(i+1,j+1,k), id(i,j+1,k), 
+                            id(i,j,k+1), id(i+1,j,k+1), id(i+1,j+1,k+1), id(i,j+1,k+1)]
+        e += 1
+    end
+
+    return coords, elements
+end
+
+
+function testtet1()
+    # Test calculation of Bfield generated by a long, thin bar of hexahedral elements
+
+    println("Testing Tetrahedron - Long Bar")
+
+    a = 0.1
+    L = 100.0
+    J = 1e5
+    r = 1.0
+    coords, elements = hexgrid([-a/2, a/2], [-a/2, a/2], range(-L/2, L/2, 101))
+    tets = maketets(coords, elements, repeat([0 0 J], size(elements)[1]))
+
+    B = bfield([r 0 0], tets)
+
+    # Finite-length filament carrying the same current
+    Bexact = mu0*J*a^2/(4*pi*r) * L/sqrt((L/2)^2 + r^2)
+
+    if isapprox(B[2], Bexact, rtol=1e-4) && length(tets) == 5*size(elements)[1]
+        return true 
+    else 
+        return false 
+    end 
+end
+
+
+function testtet2()
+    # Refining an element must not change the field, inside or outside of it
+
+    println("Testing Tetrahedron - Refinement")
+
+    J = [1e6 -2e6 5e5]
+    coords1, elements1 = hexgrid([0, 1], [0, 1], [0, 1])
+    coords2, elements2 = hexgrid(0:0.5:1, 0:0.5:1, 0:0.5:1)
+    tets1 = maketets(coords1, elements1, J)
+    tets2 = maketets(coords2, elements2, repeat(J, 8))
+    nodes = [0.3 0.6 0.2; 0.5 0.5 0.5; 1.0 0.4 0.7; 2.0 -1.0 0.5]
+
+    if isapprox(bfield(nodes, tets1), bfield(nodes, tets2), rtol=1e-4)
+        return true 
+    else 
+        return false 
+    end 
+end
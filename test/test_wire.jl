@@ -79,6 +79,63 @@ function testwire3()
     end 
 end
 
+function testsingular()
+    # Test the treatment of nodes on the axis of a Wire and on the filament of a Ring 
+    # with each singularity policy
+
+    println("Testing Singularities")
+
+    I = 1000
+    wire = Wire([0,0,0],[0,0,1],I,0.01)
+    ring = CircularRing("", 0.0, 1.0, 0.01, I)
+
+    # Wire axis inside the conductor, at an end, beyond the ends; ring filament, 
+    # centre and axis
+    wnodes = [0 0 0.5; 0 0 1; 0 0 1.5; 0 0 -2]
+    rnodes = [1 0 0; 0 0 0; 0 0 1]
+
+    # Close to the axis beyond the end, where a.c/|c| - a.b/|b| cancels
+    rho = 1e-6
+    near = [rho 0 2]
+    Bnear = mu0*I/(4*pi*rho) * (2/sqrt(4 + big(rho)^2) - 1/sqrt(1 + big(rho)^2))
+
+    passed = true
+    for policy in ["zero", "limit", "flag"]
+        Wired.singularity = policy
+        wcounts = zeros(Int32, 4)
+        rcounts = zeros(Int32, 3)
+        Bw = bfield(wnodes, [wire]; counts=wcounts)
+        Br = bfield(rnodes, [ring]; counts=rcounts)
+
+        # Beyond the ends of the wire, the axis is only singular for "zero" (0/0)
+        passed &= (wcounts == (policy == "zero" ? [1, 1, 1, 1] : [1, 1, 0, 0])) && (rcounts == [1, 0, 0])
+        if policy == "flag"
+            passed &= all(isnan, Bw[1:2,:]) && all(isnan, Br[1,:])
+            passed &= !any(isnan, Bw[3:4,:]) && !any(isnan, Br[2:3,:])
+        else
+            passed &= all(iszero, Bw) && all(iszero, Br[1,:])
+        end
+
+        # On the axis of the ring: Bz = mu0 I R^2/(2 (R^2 + z^2)^(3/2)), Bx = By = 0
+        passed &= isapprox(Br[3,3], mu0*I/(2*2^1.5), rtol=1e-5) && Br[3,1] == 0 && Br[3,2] == 0
+
+        if policy != "zero"
+            passed &= isapprox(abs(bfield(near, [wire])[2]), Bnear, rtol=1e-4)
+        end
+
+        # Grid points along the axis (z = -2:0.5:1.5): the C kernel forms them itself
+        grid = CartesianGrid(0:0, 0:0, range(-2, 1.5, 8))
+        gcounts = zeros(Int32, 8)
+        Bg = bfield(grid, [wire]; counts=gcounts)
+        passed &= gcounts == (policy == "zero" ? ones(Int32, 8) : [0, 0, 0, 0, 1, 1, 1, 0])
+        passed &= (policy == "flag") ? all(isnan, Bg[5:7,:]) && !any(isnan, Bg[[1:4; 8],:]) : all(iszero, Bg)
+    end
+    Wired.singularity = "zero"
+
+    return passed
+end
+
+
 function plotdiff()
     Wired.precision=Float32
     Iwire = 1000